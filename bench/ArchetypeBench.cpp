@@ -0,0 +1,116 @@
+// 型の少ないArchetype(1, 2, 4個、ヒープを使わない)と多いArchetype(32個)の大きさ・構築・照合のコストの比較
+#include <cstdio>
+#include <string>
+
+#include "Bench.hpp"
+
+using namespace mvecs;
+using namespace mvecs::bench;
+
+// COMPONENT_DATAは型名からハッシュを求めるので別々の型にする
+#define BENCH_COMPONENT(Name)    \
+    struct Name : IComponentData \
+    {                            \
+        COMPONENT_DATA(Name)     \
+        float value;             \
+    };
+
+BENCH_COMPONENT(C0)
+BENCH_COMPONENT(C1)
+BENCH_COMPONENT(C2)
+BENCH_COMPONENT(C3)
+BENCH_COMPONENT(C4)
+BENCH_COMPONENT(C5)
+BENCH_COMPONENT(C6)
+BENCH_COMPONENT(C7)
+BENCH_COMPONENT(C8)
+BENCH_COMPONENT(C9)
+BENCH_COMPONENT(C10)
+BENCH_COMPONENT(C11)
+BENCH_COMPONENT(C12)
+BENCH_COMPONENT(C13)
+BENCH_COMPONENT(C14)
+BENCH_COMPONENT(C15)
+BENCH_COMPONENT(C16)
+BENCH_COMPONENT(C17)
+BENCH_COMPONENT(C18)
+BENCH_COMPONENT(C19)
+BENCH_COMPONENT(C20)
+BENCH_COMPONENT(C21)
+BENCH_COMPONENT(C22)
+BENCH_COMPONENT(C23)
+BENCH_COMPONENT(C24)
+BENCH_COMPONENT(C25)
+BENCH_COMPONENT(C26)
+BENCH_COMPONENT(C27)
+BENCH_COMPONENT(C28)
+BENCH_COMPONENT(C29)
+BENCH_COMPONENT(C30)
+BENCH_COMPONENT(C31)
+
+#undef BENCH_COMPONENT
+
+//! 1回の計測で繰り返す回数
+constexpr std::size_t OpNum = 100000;
+
+//! 計測した処理の結果を足し込む(最適化で処理が消されないようにする)
+std::size_t sink = 0;
+
+/**
+ * @brief Args...のArchetypeの構築・照合を計測する
+ *
+ * @tparam Args Archetypeの型
+ */
+template <typename... Args>
+void run()
+{
+    const std::size_t typeNum = sizeof...(Args);
+
+    report((std::to_string(typeNum) + " types: Archetype::create").c_str(), typeNum, measure(20, [&]() {
+               for (std::size_t i = 0; i < OpNum; ++i)
+               {
+                   sink += Archetype::create<Args...>().getTypeCount();
+               }
+           }), OpNum);
+
+    const Archetype& archetype = Archetype::get<Args...>();
+
+    // Queryの照合(持つ型の集合の包含判定) 一致するものとしないものを交互に渡す(ループの外に出されないように)
+    const Archetype* const queries[] = {&Archetype::get<C0>(), &Archetype::get<C0, C31>(), &Archetype::get<C1>(), &Archetype::get<C30>()};
+    report((std::to_string(typeNum) + " types: isIn(Archetype)").c_str(), typeNum, measure(20, [&]() {
+               std::size_t matched = 0;
+               for (std::size_t i = 0; i < OpNum; ++i)
+               {
+                   matched += archetype.isIn(*queries[i % 4]) ? 1 : 0;
+               }
+               sink += matched;
+           }), OpNum);
+
+    // 全ての型を順に引く(平均的な位置の型の添字を求めるコスト)
+    const std::size_t hashes[] = {std::size_t(Args::getTypeHash())...};
+    report((std::to_string(typeNum) + " types: getTypeIndex").c_str(), typeNum, measure(20, [&]() {
+               std::size_t indexSum = 0;
+               for (std::size_t i = 0; i < OpNum; ++i)
+               {
+                   indexSum += archetype.getTypeIndex(hashes[i % typeNum]);
+               }
+               sink += indexSum;
+           }), OpNum);
+}
+
+int main()
+{
+    std::printf("sizeof(Archetype) = %zu bytes (InlineTypeNum = %zu)\n", sizeof(Archetype), Archetype::InlineTypeNum);
+
+    header("ArchetypeBench (100000 ops per run, n = types in the archetype)");
+
+    run<C0>();
+    run<C0, C1>();
+    run<C0, C1, C2, C3>();
+    run<C0, C1, C2, C3, C4, C5, C6, C7, C8, C9, C10, C11, C12, C13, C14, C15,
+        C16, C17, C18, C19, C20, C21, C22, C23, C24, C25, C26, C27, C28, C29, C30, C31>();
+
+    std::printf("(sink %zu)\n", sink);
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef MVECS_BENCH_BENCH_HPP_
+#define MVECS_BENCH_BENCH_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include <MVECS/MVECS.hpp>
+
+namespace mvecs::bench
+{
+    //! ベンチマーク用のCommon(中身は使わない)
+    struct Common
+    {
+    };
+
+    //! ベンチマーク用のApplication, World
+    using BenchApplication = Application<int, Common>;
+    using BenchWorld       = World<int, Common>;
+
+    /**
+     * @brief funcを1回ずつ計測し、中央値を返す(最初の1回は計測しない)
+     * @details prepareは各計測の直前に呼ばれ、計測時間に含まれない
+     * @param repeat 計測回数
+     * @param prepare 計測前の準備
+     * @param func 計測する処理
+     * @return double 1回あたりの時間(マイクロ秒)の中央値
+     */
+    template <typename Prepare, typename Func>
+    double measure(const std::size_t repeat, Prepare&& prepare, Func&& func)
+    {
+        std::vector<double> samples;
+        samples.reserve(repeat);
+
+        for (std::size_t i = 0; i <= repeat; ++i)
+        {
+            prepare();
+
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            const auto end = std::chrono::steady_clock::now();
+
+            if (i != 0)
+            {
+                samples.emplace_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+        }
+
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    /**
+     * @brief 準備の要らない処理を計測する
+     *
+     * @param repeat 計測回数
+     * @param func 計測する処理
+     * @return double 1回あたりの時間(マイクロ秒)の中央値
+     */
+    template <typename Func>
+    double measure(const std::size_t repeat, Func&& func)
+    {
+        return measure(repeat, [] {}, func);
+    }
+
+    /**
+     * @brief 計測結果を1行表示する
+     * @details itemNumを渡すと、1要素あたりの時間(ナノ秒)も表示する(要素数によらず一定かを見るため)
+     * @param name 計測した処理の名前
+     * @param param 条件(Entity数など)
+     * @param us 時間(マイクロ秒)
+     * @param itemNum 1回の計測で処理した要素数(0の場合は表示しない)
+     */
+    inline void report(const char* name, const std::size_t param, const double us, const std::size_t itemNum = 0)
+    {
+        if (itemNum == 0)
+        {
+            std::printf("%-40s %10zu %14.2f us\n", name, param, us);
+            return;
+        }
+
+        std::printf("%-40s %10zu %14.2f us %10.2f ns/item\n", name, param, us, us * 1000.0 / itemNum);
+    }
+
+    /**
+     * @brief 表の見出しを表示する
+     *
+     * @param title ベンチマークの名前
+     */
+    inline void header(const char* title)
+    {
+        std::printf("== %s ==\n%-40s %10s %17s\n", title, "case", "n", "median");
+    }
+}  // namespace mvecs::bench
+
+#endif
@@ -0,0 +1,60 @@
+// std::functionを受け取るforEachと、関数オブジェクトの引数から型を求めるforEachの比較(位置の積分)
+#include <functional>
+
+#include "Bench.hpp"
+
+using namespace mvecs;
+using namespace mvecs::bench;
+
+struct Position : IComponentData
+{
+    COMPONENT_DATA(Position)
+    float x, y, z;
+};
+
+struct Velocity : IComponentData
+{
+    COMPONENT_DATA(Velocity)
+    float x, y, z;
+};
+
+int main()
+{
+    constexpr float DeltaTime = 1.f / 60.f;
+
+    BenchApplication app;
+    BenchWorld& world = app.add(0);
+
+    header("ForEachBench (Position += Velocity * dt)");
+
+    std::size_t createdNum = 0;
+    for (const std::size_t entityNum : {1000u, 100000u, 1000000u})
+    {
+        world.createEntities<Position, Velocity>(entityNum - createdNum);
+        createdNum = entityNum;
+
+        const std::size_t repeat = entityNum >= 1000000 ? 10 : 50;
+
+        const std::function<void(Position&, const Velocity&)> integrate = [](Position& pos, const Velocity& vel)
+        {
+            pos.x += vel.x * DeltaTime;
+            pos.y += vel.y * DeltaTime;
+            pos.z += vel.z * DeltaTime;
+        };
+
+        report("forEach std::function", entityNum, measure(repeat, [&]() {
+                   world.forEach<Position, const Velocity>(integrate);
+               }));
+
+        report("forEach deduced callable", entityNum, measure(repeat, [&]() {
+                   world.forEach([](Position& pos, const Velocity& vel)
+                                 {
+                                     pos.x += vel.x * DeltaTime;
+                                     pos.y += vel.y * DeltaTime;
+                                     pos.z += vel.z * DeltaTime;
+                                 });
+               }));
+    }
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Chunk内の列の並べ方(SoA / AoSoA)による、全Entityを辿る処理の比較
+#include "Bench.hpp"
+
+using namespace mvecs;
+using namespace mvecs::bench;
+
+struct Position : IComponentData
+{
+    COMPONENT_DATA(Position)
+    float x, y, z;
+};
+
+struct Velocity : IComponentData
+{
+    COMPONENT_DATA(Velocity)
+    float x, y, z;
+};
+
+// 一緒に読まれない大きいComponentData(SoAでは別の列、AoSoAでは同じブロックに並ぶ)
+struct Payload : IComponentData
+{
+    COMPONENT_DATA(Payload)
+    float data[16];
+};
+
+/**
+ * @brief 指定した並べ方のWorldで各処理を計測する
+ *
+ * @param world 計測に使うWorld(まだEntityを構築していないこと)
+ * @param layout 列の並べ方
+ * @param entityNum Entity数
+ */
+void run(BenchWorld& world, const ColumnLayout layout, const std::size_t entityNum)
+{
+    world.setColumnLayout<Position, Velocity, Payload>(layout);
+    world.createEntities<Position, Velocity, Payload>(entityNum);
+
+    const bool soa           = layout == ColumnLayout::SoA;
+    const std::size_t repeat = entityNum >= 1000000 ? 10 : 50;
+
+    report(soa ? "forEach SoA" : "forEach AoSoA", entityNum, measure(repeat, [&]() {
+               world.forEach([](Position& pos, const Velocity& vel)
+                             {
+                                 pos.x += vel.x;
+                                 pos.y += vel.y;
+                                 pos.z += vel.z;
+                             });
+           }));
+
+    // ブロック毎にポインタで辿る(SoAでは1ブロックになる)
+    report(soa ? "forEachChunk getBlock SoA" : "forEachChunk getBlock AoSoA", entityNum, measure(repeat, [&]() {
+               world.forEachChunk<Position, Velocity>([](std::size_t, const Entity*, ComponentArray<Position>& positions, ComponentArray<Velocity>& velocities)
+                                                      {
+                                                          for (std::size_t b = 0; b < positions.getBlockNum(); ++b)
+                                                          {
+                                                              Position* MVECS_RESTRICT pPos       = positions.getBlock(b);
+                                                              const Velocity* MVECS_RESTRICT pVel = velocities.getBlock(b);
+                                                              const std::size_t size              = positions.getBlockSize(b);
+                                                              for (std::size_t i = 0; i < size; ++i)
+                                                              {
+                                                                  pPos[i].x += pVel[i].x;
+                                                                  pPos[i].y += pVel[i].y;
+                                                                  pPos[i].z += pVel[i].z;
+                                                              }
+                                                          }
+                                                      });
+           }));
+
+    // 全要素が連続している場合のみ使えるイテレータ(ポインタ)で辿る
+    if (soa)
+    {
+        report("forEachChunk iterator SoA", entityNum, measure(repeat, [&]() {
+                   world.forEachChunk<Position, Velocity>([](std::size_t, const Entity*, ComponentArray<Position>& positions, ComponentArray<Velocity>& velocities)
+                                                          {
+                                                              const Velocity* pVel = velocities.cbegin();
+                                                              for (Position& pos : positions)
+                                                              {
+                                                                  pos.x += pVel->x;
+                                                                  pos.y += pVel->y;
+                                                                  pos.z += pVel->z;
+                                                                  ++pVel;
+                                                              }
+                                                          });
+               }));
+    }
+}
+
+int main()
+{
+    BenchApplication app;
+
+    header("LayoutBench (Position += Velocity, Payload is not read)");
+
+    int key = 0;
+    for (const std::size_t entityNum : {10000u, 1000000u})
+    {
+        for (const ColumnLayout layout : {ColumnLayout::SoA, ColumnLayout::AoSoA})
+        {
+            // 並べ方はEntityを構築する前にしか設定できないので、計測毎にWorldを作る
+            run(app.add(key++), layout, entityNum);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+// 呼ぶ度にスレッドを構築・joinする並列実行(以前のforEachParallel)と、常駐ワーカー(ThreadPool)による並列実行の比較
+#include <array>
+#include <functional>
+#include <thread>
+
+#include "Bench.hpp"
+
+using namespace mvecs;
+using namespace mvecs::bench;
+
+struct Position : IComponentData
+{
+    COMPONENT_DATA(Position)
+    float x, y, z;
+};
+
+//! 比較に使うスレッド数(呼び出し元を含む)
+constexpr std::size_t ThreadNum = 4;
+
+/**
+ * @brief 各配列の[threadIndex]番目の範囲の行を更新する(以前のforEachParallelと同じ分け方)
+ *
+ * @param arrays 全ChunkのComponentArray
+ * @param threadIndex スレッドの添字
+ */
+void integrate(std::vector<ComponentArray<Position>>& arrays, const std::size_t threadIndex)
+{
+    for (auto& array : arrays)
+    {
+        const std::size_t begin = threadIndex * array.size() / ThreadNum;
+        const std::size_t end   = (threadIndex + 1) * array.size() / ThreadNum;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            array[i].x += 1.f;
+        }
+    }
+}
+
+int main()
+{
+    BenchApplication app;
+    BenchWorld& world = app.add(0);
+    ThreadPool pool(ThreadNum);
+
+    header("PoolBench (Position.x += 1, 4 threads)");
+
+    std::size_t createdNum = 0;
+    for (const std::size_t entityNum : {1000u, 1000000u})
+    {
+        world.createEntities<Position>(entityNum - createdNum);
+        createdNum = entityNum;
+
+        std::vector<ComponentArray<Position>> arrays;
+        world.forEachChunk<Position>([&](std::size_t, const Entity*, ComponentArray<Position>& array)
+                                     { arrays.emplace_back(array); });
+
+        const std::size_t repeat = entityNum >= 1000000 ? 20 : 200;
+
+        report("spawn threads per call", entityNum, measure(repeat, [&]() {
+                   std::array<std::thread, ThreadNum> threads;
+                   for (std::size_t i = 0; i < ThreadNum; ++i)
+                   {
+                       threads[i] = std::thread([&arrays, i]() { integrate(arrays, i); });
+                   }
+                   for (auto& thread : threads)
+                   {
+                       thread.join();
+                   }
+               }));
+
+        report("ThreadPool::run", entityNum, measure(repeat, [&]() {
+                   pool.run([&arrays](const std::size_t threadIndex) { integrate(arrays, threadIndex); });
+               }));
+
+        // Applicationの常駐ワーカー(hardware_concurrencyスレッド)で実行する
+        report("forEachParallel", entityNum, measure(repeat, [&]() {
+                   world.forEachParallel<Position>([](Position& pos) { pos.x += 1.f; });
+               }));
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Chunk::deallocateの行の詰め方(SwapAndPop / KeepOrder)と、まとめて破棄するdestroyEntitiesの比較
+#include "Bench.hpp"
+
+using namespace mvecs;
+using namespace mvecs::bench;
+
+struct Position : IComponentData
+{
+    COMPONENT_DATA(Position)
+    float x, y, z;
+};
+
+struct Velocity : IComponentData
+{
+    COMPONENT_DATA(Velocity)
+    float x, y, z;
+};
+
+int main()
+{
+    BenchApplication app;
+    BenchWorld& world = app.add(0);
+
+    header("RemovalBench (destroy every other entity)");
+
+    for (const std::size_t entityNum : {1000u, 10000u, 100000u, 1000000u})
+    {
+        std::vector<Entity> entities;
+        std::vector<Entity> removed;
+
+        // 前回の残り(破棄済みのものは無視される)を破棄して作り直し、1つおきに破棄するEntityを選ぶ
+        const auto rebuild = [&]()
+        {
+            world.destroyEntities(entities);
+            entities = world.createEntities<Position, Velocity>(entityNum);
+            removed.clear();
+            for (std::size_t i = 0; i < entityNum; i += 2)
+            {
+                removed.emplace_back(entities[i]);
+            }
+        };
+
+        const std::size_t removedNum = (entityNum + 1) / 2;
+
+        // 計測毎に作り直すため、大きいものは回数を減らす
+        const std::size_t repeat = entityNum >= 1000000 ? 3 : entityNum >= 100000 ? 5 : 20;
+
+        report("destroyEntity SwapAndPop", entityNum, measure(repeat, rebuild, [&]() {
+                   for (const auto& e : removed)
+                   {
+                       world.destroyEntity(e, RemovalMode::SwapAndPop);
+                   }
+               }), removedNum);
+
+        // KeepOrderは1件毎にO(n)で全体はO(n^2)になるため、大きいものは計測しない
+        if (entityNum <= 10000)
+        {
+            report("destroyEntity KeepOrder", entityNum, measure(repeat, rebuild, [&]() {
+                       for (const auto& e : removed)
+                       {
+                           world.destroyEntity(e, RemovalMode::KeepOrder);
+                       }
+                   }), removedNum);
+        }
+
+        report("destroyEntities SwapAndPop (batch)", entityNum, measure(repeat, rebuild, [&]() {
+                   world.destroyEntities(removed, RemovalMode::SwapAndPop);
+               }), removedNum);
+
+        report("destroyEntities KeepOrder (batch)", entityNum, measure(repeat, rebuild, [&]() {
+                   world.destroyEntities(removed, RemovalMode::KeepOrder);
+               }), removedNum);
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// 既存のArchetypeの数に対するcreateEntityの時間の比較(Archetypeの数によらず一定であること)
+#include <array>
+#include <tuple>
+#include <utility>
+
+#include "Bench.hpp"
+
+using namespace mvecs;
+using namespace mvecs::bench;
+
+struct Position : IComponentData
+{
+    COMPONENT_DATA(Position)
+    float x, y, z;
+};
+
+// Archetypeを増やすためだけのComponentData(COMPONENT_DATAは型名からハッシュを求めるので別々の型にする)
+#define BENCH_TAG(Name)         \
+    struct Name : IComponentData \
+    {                            \
+        COMPONENT_DATA(Name)     \
+        int value;               \
+    };
+
+BENCH_TAG(Tag0)
+BENCH_TAG(Tag1)
+BENCH_TAG(Tag2)
+BENCH_TAG(Tag3)
+BENCH_TAG(Tag4)
+BENCH_TAG(Tag5)
+
+#undef BENCH_TAG
+
+using Tags = std::tuple<Tag0, Tag1, Tag2, Tag3, Tag4, Tag5>;
+
+//! Maskの立っているビットのTagだけを並べたstd::tuple
+template <std::size_t Mask, std::size_t... Is>
+auto selectTags(std::index_sequence<Is...>) -> decltype(std::tuple_cat(std::declval<std::conditional_t<((Mask >> Is) & 1) != 0, std::tuple<std::tuple_element_t<Is, Tags>>, std::tuple<>>>()...));
+
+template <typename TagTuple>
+struct Spawner;
+
+template <typename... Ts>
+struct Spawner<std::tuple<Ts...>>
+{
+    static void spawn(BenchWorld& world)
+    {
+        world.createEntity<Position, Ts...>();
+    }
+};
+
+/**
+ * @brief Position + (Maskで選んだTag)のArchetypeのEntityを1つ構築する
+ *
+ * @tparam Mask 使うTagのビット列(0の場合はPositionのみ)
+ * @param world 構築するWorld
+ */
+template <std::size_t Mask>
+void spawnMasked(BenchWorld& world)
+{
+    Spawner<decltype(selectTags<Mask>(std::make_index_sequence<std::tuple_size_v<Tags>>()))>::spawn(world);
+}
+
+template <std::size_t... Masks>
+constexpr std::array<void (*)(BenchWorld&), sizeof...(Masks)> makeSpawnTable(std::index_sequence<Masks...>)
+{
+    return {&spawnMasked<Masks>...};
+}
+
+int main()
+{
+    constexpr std::size_t SpawnNum = 10000;
+    constexpr auto spawnTable      = makeSpawnTable(std::make_index_sequence<std::size_t(1) << std::tuple_size_v<Tags>>());
+
+    BenchApplication app;
+
+    header("SpawnBench (createEntity<Position> x 10000, n = existing archetypes)");
+
+    int key = 0;
+    for (const std::size_t archetypeNum : {1u, 8u, 64u})
+    {
+        BenchWorld& world = app.add(key++);
+
+        // 各Archetypeに1つずつEntityを構築してChunkを作っておく(Mask 0は計測するPositionのみのArchetype)
+        for (std::size_t mask = 0; mask < archetypeNum; ++mask)
+        {
+            spawnTable[mask](world);
+        }
+
+        std::vector<Entity> spawned;
+        spawned.reserve(SpawnNum);
+
+        report("createEntity", archetypeNum, measure(20, [&]() {
+                   world.destroyEntities(spawned);
+                   spawned.clear();
+               },
+               [&]() {
+                   for (std::size_t i = 0; i < SpawnNum; ++i)
+                   {
+                       spawned.emplace_back(world.createEntity<Position>());
+                   }
+               }));
+    }
+
+    return 0;
+}
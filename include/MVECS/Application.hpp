@@ -3,8 +3,13 @@
 
 #include <cassert>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
 #include <unordered_map>
 
+#include "ThreadPool.hpp"
+
 namespace mvecs
 {
     template <typename Key, typename Common>
@@ -39,11 +44,11 @@ namespace mvecs
          * @brief Worldを追加する
          *
          * @param key キー
-         * @param world World
+         * @param pMemoryResource Worldのメモリを確保するリソース(nullptrの場合はstd::pmr::get_default_resource())
          */
-        World<Key, Common>& add(const Key& key)
+        World<Key, Common>& add(const Key& key, std::pmr::memory_resource* pMemoryResource = nullptr)
         {
-            return (*mWorlds.emplace(key, this).first).second;
+            return (*mWorlds.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(this, pMemoryResource)).first).second;
         }
 
         /**
@@ -143,6 +148,21 @@ namespace mvecs
             return *mCommon;
         }
 
+        /**
+         * @brief 全Worldで共有するワーカースレッドたちを取得する(初回のみ構築する)
+         * @details forEachParallelはこれを使うため、呼ぶ度にスレッドを構築しない
+         * @return ThreadPool&
+         */
+        ThreadPool& getThreadPool()
+        {
+            if (!mpThreadPool)
+            {
+                mpThreadPool = std::make_unique<ThreadPool>();
+            }
+
+            return *mpThreadPool;
+        }
+
     private:
         using umap = std::unordered_map<Key, World<Key, Common>>;
         umap mWorlds;
@@ -151,6 +171,9 @@ namespace mvecs
 
         std::unique_ptr<Common> mCommon;
 
+        //! forEachParallelで使うワーカースレッドたち(初めて使う時に構築する)
+        std::unique_ptr<ThreadPool> mpThreadPool;
+
         bool mEnded;
         bool mInitialized;
     };
@@ -1,29 +1,41 @@
 #ifndef MVECS_MVECS_ARCHETYPE_HPP_
 #define MVECS_MVECS_ARCHETYPE_HPP_
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <limits>
 #include <type_traits>
 
+#include "ComponentRegistry.hpp"
+#include "ComponentSignature.hpp"
 #include "IComponentData.hpp"
+#include "SmallVector.hpp"
 #include "TypeInfo.hpp"
 
 namespace mvecs
 {
 
     /**
-     * @brief Chunkが持つ型(Entityが持つ型)の情報を定義するもの 基本的にコンパイル時処理
-     *
+     * @brief Chunkが持つ型(Entityが持つ型)の情報を定義するもの
+     * @details 型の並べ替えなどは定数式でも行えるが、持つ型の集合を表すComponentSignatureは実行時に割り当てるIDから作る
+     *          そのため型から構築する場合はget<Args...>()で型毎にキャッシュしたものを使う
+     *          1つのArchetypeが持てる型の数に個別の上限は無いが、プロセス全体で登録できる型は
+     *          ComponentRegistry::MaxComponentTypeNum(256)種類までなので、それが実質的な上限になる
+     *          (create<Args...>()はそれを超える型の並びをコンパイル時に弾き、257種類目の型の登録は実行時にabortする)
+     *          InlineTypeNum(4)個以下の型はヒープを使わずに持つ
      */
     class Archetype
     {
     public:
-        //! Archetypeが持てる型情報の個数の限界
-        static constexpr std::size_t MaxTypeNum = 16;
-
-        constexpr Archetype()
-            : mTypeIndexTable()
+        //! Archetypeが持てる型情報の個数の限界(ComponentSignatureで表せるIDの個数)
+        static constexpr std::size_t MaxTypeNum = ComponentRegistry::MaxComponentTypeNum;
+        //! ヒープを使わずに持てる型情報の個数(これを超えるとヒープに確保する)
+        static constexpr std::size_t InlineTypeNum = 4;
+        //! 各型の列の先頭の最小アラインメント(キャッシュライン)
+        static constexpr std::size_t ColumnAlignment = 64;
+
+        Archetype()
         {
         }
 
@@ -34,22 +46,9 @@ namespace mvecs
          * @return true 同一
          * @return false 同一でない
          */
-        constexpr bool operator==(const Archetype& other) const
+        bool operator==(const Archetype& other) const
         {
-            if (mTypeCount != other.mTypeCount)
-            {
-                return false;
-            }
-
-            for (std::size_t i = 0; i < mTypeCount; ++i)
-            {
-                if (mTypes[i] != other.mTypes[i])
-                {
-                    return false;
-                }
-            }
-
-            return true;
+            return mSignature == other.mSignature;
         }
 
         /**
@@ -59,7 +58,7 @@ namespace mvecs
          * @return true 同一
          * @return false 同一でない
          */
-        constexpr bool operator!=(const Archetype& other) const
+        bool operator!=(const Archetype& other) const
         {
             return !(*this == other);
         }
@@ -71,33 +70,21 @@ namespace mvecs
          * @return true 部分集合
          * @return false 部分集合でない
          */
-        constexpr bool isIn(const Archetype& other) const
+        bool isIn(const Archetype& other) const
         {
-            if (mTypeCount < other.mTypeCount)
-            {
-                return false;
-            }
-
-            bool in = false;
-            for (std::size_t i = 0; i < other.mTypeCount; ++i)
-            {
-                in = false;
-                for (std::size_t j = 0; j < mTypeCount && other.mTypes[i].getHash() <= mTypes[j].getHash(); ++j)
-                {
-                    if (other.mTypes[i] == mTypes[j])
-                    {
-                        in = true;
-                        break;
-                    }
-                }
-
-                if (!in)
-                {
-                    return false;
-                }
-            }
+            return mSignature.contains(other.mSignature);
+        }
 
-            return true;
+        /**
+         * @brief otherと共通する型を1つでも持つかどうか
+         *
+         * @param other 判定対象
+         * @return true 共通する型がある
+         * @return false 共通する型が無い
+         */
+        bool intersects(const Archetype& other) const
+        {
+            return mSignature.intersects(other.mSignature);
         }
 
         /**
@@ -109,10 +96,21 @@ namespace mvecs
          * @return false 持たない
          */
         template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
-        constexpr bool isIn() const
+        bool isIn() const
+        {
+            return mSignature.test(ComponentRegistry::getID<T>());
+        }
+
+        /**
+         * @brief そのComponentData型を持つかどうか(ハッシュ値版)
+         *
+         * @param hash ComponentData型のハッシュ
+         * @return true 持つ
+         * @return false 持たない
+         */
+        bool isIn(std::uint32_t hash) const
         {
-            std::uint32_t hash = T::getTypeHash();
-            for (std::size_t i = 0; i < mTypeCount && hash <= mTypes[i].getHash(); ++i)
+            for (std::size_t i = 0; i < mTypes.size() && hash <= mTypes[i].getHash(); ++i)
             {
                 if (mTypes[i].getHash() == hash)
                 {
@@ -128,37 +126,105 @@ namespace mvecs
          *
          * @tparam T ComponentData型
          * @tparam typename ComponentData型判定用
-         * @return constexpr std::size_t その型のある添字
+         * @return std::size_t その型のある添字(持たない場合はstd::numeric_limits<std::size_t>::max())
          */
         template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
-        constexpr std::size_t getTypeIndex() const
+        std::size_t getTypeIndex() const
+        {
+            return getTypeIndex(T::getTypeHash());
+        }
+
+        /**
+         * @brief その型までのメモリ上のオフセットを取得する
+         * @details 各列の先頭はgetColumnAlignmentの倍数になるように詰め物が入る(SoA用、AoSoAのブロック内はgetBlockTypeOffset)
+         * @param indexUntil 型の添字
+         * @param coef 係数(単に各型のサイズに掛けられる)
+         * @return std::size_t オフセット(バイト)
+         */
+        std::size_t getTypeOffset(std::size_t indexUntil, std::size_t coef) const
         {
-            std::uint32_t hash = T::getTypeHash();
-            for (std::size_t i = 0; i < mTypeCount && hash <= mTypes[i].getHash(); ++i)
+            assert(indexUntil < mTypes.size());
+            std::size_t rtn = 0;
+            for (std::size_t i = 0; i < indexUntil; ++i)
             {
-                if (mTypes[i].getHash() == hash)
-                {
-                    return i;
-                }
+                rtn = alignUp(rtn + coef * mTypes[i].getSize(), getColumnAlignment(i + 1));
             }
 
-            assert(!"the type is not in this archetype!");
+            return rtn;
         }
 
         /**
-         * @brief その型までのメモリ上のオフセットを取得する
+         * @brief 全ての列を収めるのに必要なメモリのサイズを取得する(列の間の詰め物を含む)
          *
+         * @param coef 係数(列のEntity数)
+         * @return std::size_t サイズ(バイト)
+         */
+        std::size_t getMemorySize(std::size_t coef) const
+        {
+            std::size_t rtn = 0;
+            for (std::size_t i = 0; i < mTypes.size(); ++i)
+            {
+                rtn = alignUp(rtn, getColumnAlignment(i)) + coef * mTypes[i].getSize();
+            }
+
+            return rtn;
+        }
+
+        /**
+         * @brief ブロック(AoSoA)内でのその型までのオフセットを取得する
+         * @details ブロック内の列は型のアラインメントにのみ揃える(ColumnAlignmentに揃えるのはブロックの先頭のみ)
+         *          そのため小さい型の列でもブロック毎に詰め物が入らない
          * @param indexUntil 型の添字
-         * @param coef 係数(単に各型のサイズに掛けられる)
-         * @return constexpr std::size_t オフセット(バイト)
+         * @param blockEntityNum 1ブロックあたりのEntity数
+         * @return std::size_t ブロックの先頭からのオフセット(バイト)
          */
-        constexpr std::size_t getTypeOffset(std::size_t indexUntil, std::size_t coef) const
+        std::size_t getBlockTypeOffset(std::size_t indexUntil, std::size_t blockEntityNum) const
         {
-            assert(indexUntil < mTypeCount);
+            assert(indexUntil < mTypes.size());
             std::size_t rtn = 0;
             for (std::size_t i = 0; i < indexUntil; ++i)
             {
-                rtn += coef * mTypes[i].getSize();
+                rtn = alignUp(rtn + blockEntityNum * mTypes[i].getSize(), mTypes[i + 1].getAlignment());
+            }
+
+            return rtn;
+        }
+
+        /**
+         * @brief ブロック(各型のblockEntityNum個の要素を列の順に並べたもの)1つ分のサイズを取得する
+         * @details ブロックの先頭がgetMemoryAlignment(ColumnAlignment以上)に揃うように切り上げる
+         * @param blockEntityNum 1ブロックあたりのEntity数
+         * @return std::size_t サイズ(バイト)
+         */
+        std::size_t getBlockStride(std::size_t blockEntityNum) const
+        {
+            const std::size_t last = mTypes.size() - 1;
+            return alignUp(getBlockTypeOffset(last, blockEntityNum) + blockEntityNum * mTypes[last].getSize(), getMemoryAlignment());
+        }
+
+        /**
+         * @brief [index]番目の型の列の先頭のアラインメントを取得する
+         *
+         * @param index 型の添字
+         * @return std::size_t max(型のアラインメント, ColumnAlignment)
+         */
+        std::size_t getColumnAlignment(std::size_t index) const
+        {
+            assert(index < mTypes.size());
+            return mTypes[index].getAlignment() > ColumnAlignment ? mTypes[index].getAlignment() : ColumnAlignment;
+        }
+
+        /**
+         * @brief 全ての列を収めるメモリの先頭に必要なアラインメントを取得する
+         *
+         * @return std::size_t アラインメント
+         */
+        std::size_t getMemoryAlignment() const
+        {
+            std::size_t rtn = ColumnAlignment;
+            for (std::size_t i = 0; i < mTypes.size(); ++i)
+            {
+                rtn = getColumnAlignment(i) > rtn ? getColumnAlignment(i) : rtn;
             }
 
             return rtn;
@@ -168,11 +234,11 @@ namespace mvecs
          * @brief 指定したComponentData型の添字を取得する(ハッシュ値版)
          *
          * @param hash ComponentData型のハッシュ
-         * @return constexpr std::size_t その型のある添字
+         * @return std::size_t その型のある添字(持たない場合はstd::numeric_limits<std::size_t>::max())
          */
-        constexpr std::size_t getTypeIndex(std::size_t hash)
+        std::size_t getTypeIndex(std::size_t hash) const
         {
-            for (std::size_t i = 0; i < mTypeCount && hash <= mTypes[i].getHash(); ++i)
+            for (std::size_t i = 0; i < mTypes.size() && hash <= mTypes[i].getHash(); ++i)
             {
                 if (mTypes[i].getHash() == hash)
                 {
@@ -188,9 +254,9 @@ namespace mvecs
          * @brief ComponentData型のArchetype上での添字から元の添字を取得する
          *
          * @param typeIndex Archtype上での添字(getTypeIndexで取得できるもの)
-         * @return constexpr std::size_t その型の元の添字
+         * @return std::size_t その型の元の添字
          */
-        constexpr std::size_t getReverseTypeIndex(std::size_t typeIndex)
+        std::size_t getReverseTypeIndex(std::size_t typeIndex)
         {
             return mTypeIndexTable[typeIndex];
         }
@@ -199,11 +265,11 @@ namespace mvecs
          * @brief 指定したindexの型のハッシュ値を取得する
          *
          * @param index
-         * @return constexpr std::size_t
+         * @return std::size_t
          */
-        constexpr std::size_t getTypeHash(std::size_t index)
+        std::size_t getTypeHash(std::size_t index)
         {
-            assert(index < mTypeCount);
+            assert(index < mTypes.size());
             return mTypes[index].getHash();
         }
 
@@ -211,75 +277,204 @@ namespace mvecs
          * @brief 型からArchetypeを構築する
          *
          * @tparam Args 構築する型、TypeInfo制約を満たすもの
-         * @return constexpr Archetype 作成したインスタンス
+         * @return Archetype 作成したインスタンス
          */
         template <typename... Args>
-        static constexpr Archetype create()
+        static Archetype create()
         {
+            static_assert(sizeof...(Args) <= ComponentRegistry::MaxComponentTypeNum, "too many ComponentData types in one archetype!");
+
             Archetype rtn;
+            rtn.mTypes.reserve(sizeof...(Args));
+            rtn.mTypeIndexTable.reserve(sizeof...(Args));
             rtn.createImpl<Args...>();
 
-            // ソートする(降順)
-            std::size_t maxIndex = 0;
-            TypeInfo tmp;
-            std::size_t tmp2 = 0;
-            for (std::size_t i = 0; i < MaxTypeNum - 1; ++i)
+            // ハッシュの降順に並べ替える(元の添字を並べ替えてから型情報を並べ直す)
+            std::sort(rtn.mTypeIndexTable.begin(), rtn.mTypeIndexTable.end(), [&rtn](const std::size_t l, const std::size_t r)
+                      { return rtn.mTypes[l].getHash() > rtn.mTypes[r].getHash(); });
+
+            SmallVector<TypeInfo, InlineTypeNum> sorted;
+            sorted.reserve(rtn.mTypes.size());
+            for (const std::size_t index : rtn.mTypeIndexTable)
             {
-                maxIndex = i;
+                sorted.push_back(rtn.mTypes[index]);
+            }
+            rtn.mTypes = std::move(sorted);
 
-                for (std::size_t j = i + 1; j < MaxTypeNum; ++j)
+            return rtn;
+        }
+
+        /**
+         * @brief 型から構築したArchetypeを取得する(型の組み合わせ毎に1回だけ構築する)
+         *
+         * @tparam Args 構築する型、TypeInfo制約を満たすもの
+         * @return const Archetype& キャッシュしたインスタンス
+         */
+        template <typename... Args>
+        static const Archetype& get()
+        {
+            static const Archetype archetype = create<Args...>();
+            return archetype;
+        }
+
+        /**
+         * @brief 持つ型の集合を取得する
+         *
+         * @return const ComponentSignature&
+         */
+        const ComponentSignature& getSignature() const
+        {
+            return mSignature;
+        }
+
+        /**
+         * @brief 型を1つ追加したArchetypeを構築する(実行時にComponentDataを追加する場合に使う)
+         *
+         * @param type 追加する型(まだ持っていないこと)
+         * @return Archetype 追加したArchetype
+         */
+        Archetype added(const TypeInfo& type) const
+        {
+            assert(!isIn(type.getHash()) || !"the type is already in this archetype!");
+            assert(mTypes.size() < MaxTypeNum || !"over max ComponentData type num!");
+
+            Archetype rtn;
+            rtn.mTypes.reserve(mTypes.size() + 1);
+            rtn.mTypeIndexTable.reserve(mTypes.size() + 1);
+            for (std::size_t i = 0; i < mTypes.size(); ++i)
+            {
+                // 降順を保つ位置に挿入する
+                if (rtn.mTypes.size() == i && type.getHash() > mTypes[i].getHash())
                 {
-                    if (rtn.mTypes[maxIndex].getHash() < rtn.mTypes[j].getHash())
-                    {
-                        maxIndex = j;
-                    }
+                    rtn.push(type);
                 }
 
-                tmp = rtn.mTypes[maxIndex];
-                rtn.mTypes[maxIndex] = rtn.mTypes[i];
-                rtn.mTypes[i] = tmp;
+                rtn.push(mTypes[i]);
+            }
+
+            if (rtn.mTypes.size() == mTypes.size())
+            {
+                rtn.push(type);
+            }
+
+            return rtn;
+        }
+
+        /**
+         * @brief 型を1つ削除したArchetypeを構築する(実行時にComponentDataを削除する場合に使う)
+         *
+         * @param hash 削除する型のハッシュ(持っていること)
+         * @return Archetype 削除したArchetype
+         */
+        Archetype removed(std::uint32_t hash) const
+        {
+            assert(isIn(hash) || !"the type is not in this archetype!");
 
-                tmp2 = rtn.mTypeIndexTable[maxIndex];
-                rtn.mTypeIndexTable[maxIndex] = rtn.mTypeIndexTable[i];
-                rtn.mTypeIndexTable[i] = tmp2;
+            Archetype rtn;
+            rtn.mTypes.reserve(mTypes.size() - 1);
+            rtn.mTypeIndexTable.reserve(mTypes.size() - 1);
+            for (std::size_t i = 0; i < mTypes.size(); ++i)
+            {
+                if (mTypes[i].getHash() != hash)
+                {
+                    rtn.push(mTypes[i]);
+                }
             }
 
             return rtn;
         }
 
+        /**
+         * @brief [index]番目の型の情報を取得する
+         *
+         * @param index 型の添字
+         * @return const TypeInfo& 型情報
+         */
+        const TypeInfo& getTypeInfo(std::size_t index) const
+        {
+            assert(index < mTypes.size());
+            return mTypes[index];
+        }
+
+        /**
+         * @brief 全ての型がtrivially copyableかどうか
+         *
+         * @return true 全ての型がtrivially copyable
+         * @return false そうでない型がある
+         */
+        bool isTriviallyCopyable() const
+        {
+            for (std::size_t i = 0; i < mTypes.size(); ++i)
+            {
+                if (!mTypes[i].isTriviallyCopyable())
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
         /**
          * @brief [index]番目の型のサイズを取得する
          *
          * @param index 型の添字
-         * @return constexpr std::size_t サイズ
+         * @return std::size_t サイズ
          */
-        constexpr std::size_t getTypeSize(std::size_t index) const
+        std::size_t getTypeSize(std::size_t index) const
         {
-            assert(index < mTypeCount);
+            assert(index < mTypes.size());
             return mTypes[index].getSize();
         }
 
         /**
          * @brief 型の個数を取得する
          *
-         * @return constexpr std::size_t 個数
+         * @return std::size_t 個数
          */
-        constexpr std::size_t getTypeCount() const
+        std::size_t getTypeCount() const
         {
-            return mTypeCount;
+            return mTypes.size();
         }
 
         /**
          * @brief 全ての型のサイズの総和を取得する
          *
-         * @return constexpr std::size_t サイズの総和
+         * @return std::size_t サイズの総和
          */
-        constexpr std::size_t getAllTypeSize() const
+        std::size_t getAllTypeSize() const
         {
             return mAllTypeSize;
         }
 
     private:
+        /**
+         * @brief valueをalignmentの倍数に切り上げる
+         *
+         * @param value 値
+         * @param alignment アラインメント(2の冪)
+         * @return std::size_t 切り上げた値
+         */
+        static constexpr std::size_t alignUp(std::size_t value, std::size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        /**
+         * @brief 末尾に型を追加する(added, removedで使う、順序はそのまま)
+         *
+         * @param type 追加する型
+         */
+        void push(const TypeInfo& type)
+        {
+            assert(mTypes.size() < MaxTypeNum || !"over max ComponentData type num!");
+
+            mTypeIndexTable.push_back(mTypes.size());
+            mTypes.push_back(type);
+            mAllTypeSize += type.getSize();
+            mSignature.set(ComponentRegistry::registerType(type));
+        }
+
         /**
          * @brief create()の可変長テンプレート引数展開処理の実装部
          *
@@ -287,18 +482,18 @@ namespace mvecs
          * @tparam Tails
          */
         template <typename Head, typename... Tails>
-        constexpr void createImpl()
+        void createImpl()
         {
             assert(IsComponentDataType<Head> || !"the type is not ComponentData!");
 
             {
-                mTypes[mTypeCount] = TypeInfo::create<Head>();
-                mTypeIndexTable[mTypeCount] = mTypeCount;
-                mTypeCount++;
+                mTypeIndexTable.push_back(mTypes.size());
+                mTypes.push_back(TypeInfo::create<Head>());
                 mAllTypeSize += sizeof(Head);
+                mSignature.set(ComponentRegistry::getID<Head>());
             }
 
-            assert(mTypeCount <= MaxTypeNum || !"over max ComponentData type num!");
+            assert(mTypes.size() <= MaxTypeNum || !"over max ComponentData type num!");
 
             if constexpr (sizeof...(Tails) != 0)
             {
@@ -307,14 +502,14 @@ namespace mvecs
 
         }
 
-        //! 型情報(TypeInfo)の配列
-        TypeInfo mTypes[MaxTypeNum];
+        //! 型情報(TypeInfo)の配列(InlineTypeNum個まではヒープを使わない)
+        SmallVector<TypeInfo, InlineTypeNum> mTypes;
         //! Args...で渡される型の順序をどのように入れ替えたかのテーブル
-        std::size_t mTypeIndexTable[MaxTypeNum];
-        //! 現在の型の個数
-        std::size_t mTypeCount = 0;
+        SmallVector<std::size_t, InlineTypeNum> mTypeIndexTable;
         //! 型サイズの総和を事前に計算しておく
         std::size_t mAllTypeSize = 0;
+        //! 持つ型の集合(一致・包含の判定に使う)
+        ComponentSignature mSignature;
 
     };
 }  // namespace mvecs
@@ -8,6 +8,8 @@
 #ifndef MVECS_MVECS_CHUNK_HPP_
 #define MVECS_MVECS_CHUNK_HPP_
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -15,6 +17,7 @@
 #include <memory>
 #include <vector>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "Archetype.hpp"
@@ -30,7 +33,8 @@ namespace mvecs
 {
 	/**
 	 * @brief Chunkクラス Archetypeから作られる実際のメモリ上のデータ(テンプレート引数を取れる実装)
-	 *
+	 * @details ComponentDataの構築・破棄・移動はArchetypeの型情報(TypeInfo)を通して行う
+	 *          そのため、Args...が空のChunk<>も実行時に組み立てたArchetype(ComponentDataの追加・削除の移動先)から構築できる
 	 */
 	template<typename... Args>
 	class Chunk : public IChunk
@@ -39,25 +43,31 @@ namespace mvecs
 		/**
 		 * @brief 与えられたArchetypeからChunkを構築する
 		 *
-		 * @param entitySize Chunkが持つEntityの最大数
+		 * @param pEntityTable Entityの位置を登録するテーブル
+		 * @param pMemoryResource メモリを確保するリソース
+		 * @param entitySize Chunkが持つEntityの最大数(ページの場合は1ページあたりのEntity数)
+		 * @param storageMode 保持の仕方
+		 * @param columnLayout 列の並べ方
+		 * @param blockEntityNum AoSoAの場合の1ブロックあたりのEntity数(2の冪)
 		 * @return Chunk 構築したChunk
 		 */
-		static Chunk<Args...>&& create(const std::size_t ID, const Archetype& archetype, const std::size_t maxEntityNum = 1)
+		static Chunk<Args...> create(const std::size_t ID, const Archetype& archetype, EntityTable* pEntityTable, std::pmr::memory_resource* pMemoryResource, const std::size_t maxEntityNum = 1, const StorageMode storageMode = StorageMode::Contiguous, const ColumnLayout columnLayout = ColumnLayout::SoA, const std::size_t blockEntityNum = DefaultBlockEntityNum)
 		{
-			Chunk<Args...> rtn(ID, archetype);
-
-			std::size_t memSize = archetype.getAllTypeSize() * maxEntityNum;
-
-			// 割り当て
-			rtn.mpMemory = new std::byte[memSize]();
-
-			// メモリクリア(やらなくてもいいかも)
-			std::memset(rtn.mpMemory, 0, memSize);
-			rtn.mMaxEntityNum = maxEntityNum;
+			Chunk<Args...> rtn(ID, archetype, pEntityTable, pMemoryResource);
+			rtn.setColumnLayout(columnLayout, blockEntityNum);
+			rtn.mStorageMode = storageMode;
+			rtn.mPageEntityNum = storageMode == StorageMode::Paged ? maxEntityNum : 0;
+
+			// 割り当て(0で埋められる、AoSoAの場合はブロックの倍数に切り上げる)
+			const std::size_t layoutEntityNum = rtn.getLayoutEntityNum(maxEntityNum);
+			assert(storageMode == StorageMode::Contiguous || layoutEntityNum == maxEntityNum || !"page entity num must be a multiple of block entity num!");
+			rtn.mpMemory = rtn.allocateMemory(layoutEntityNum);
+			rtn.mMaxEntityNum = layoutEntityNum;
+			rtn.updateColumns();
 
 			assert(rtn.mMaxEntityNum != 0);
 
-			return std::move(rtn);
+			return rtn;
 		}
 
 		/**
@@ -65,8 +75,8 @@ namespace mvecs
 		 *
 		 * @param ID
 		 */
-		Chunk(const std::size_t ID, const Archetype& archetype)
-			: IChunk(ID, archetype)
+		Chunk(const std::size_t ID, const Archetype& archetype, EntityTable* pEntityTable, std::pmr::memory_resource* pMemoryResource)
+			: IChunk(ID, archetype, pEntityTable, pMemoryResource)
 		{
 		}
 
@@ -112,13 +122,7 @@ namespace mvecs
 		 */
 		Chunk& operator=(Chunk&& src) noexcept
 		{
-			mID = src.mID;
-			mArchetype = src.mArchetype;
-			mpMemory = src.mpMemory;
-			mMaxEntityNum = src.mMaxEntityNum;
-			mEntityNum = src.mEntityNum;
-
-			src.destroy();
+			IChunk::operator=(std::move(src));
 
 			return *this;
 		}
@@ -130,155 +134,243 @@ namespace mvecs
 		 */
 		virtual Entity allocate() override
 		{
-			std::size_t* const pIndex = new std::size_t(mEntityNum);
-			Entity entity(pIndex, mID);
+			if (mEntityNum >= mMaxEntityNum)
+			{
+				// メモリを再割り当てする
+				reallocate(getGrownEntityNum(mEntityNum + 1));
+			}
+
+			const std::size_t row = mEntityNum;
 
 			// 構築
-			for (std::size_t i = 0; i < sizeof...(Args); ++i)
-			{
-				// 書き込む型までのオフセット
-				const std::size_t offset = mArchetype.getTypeOffset(i, mMaxEntityNum);
+			constructRows(row, 1);
+
+			// スロットを割り当てて行に登録
+			const Entity entity = mpEntityTable->create(this, row);
+			mEntities.emplace_back(entity);
+
+			// 更新
+			++mEntityNum;
+			markAllChanged();
+
+			return entity;
+		}
 
-				std::byte* ptr = (mpMemory + offset + entity.getID() * mArchetype.getTypeSize(i));
+		/**
+		 * @brief 複数のEntityの領域をまとめて確保する
+		 * @details 容量の確保は1回のみで、各ComponentDataは型毎に列単位でまとめて構築される
+		 * @param count 確保するEntity数
+		 * @param entities 確保したEntityを末尾に追加する先(行の順に並ぶ)
+		 */
+		virtual void allocate(const std::size_t count, std::vector<Entity>& entities) override
+		{
+			if (count == 0)
+			{
+				return;
+			}
 
-				construct<Args...>(mArchetype.getReverseTypeIndex(i), ptr);
+			if (mEntityNum + count > mMaxEntityNum)
+			{
+				// 足りない分を1回で確保する
+				reallocate(getGrownEntityNum(mEntityNum + count));
 			}
 
-			// 新しいindexを挿入
-			mpEntityIDs.emplace_back(pIndex);
+			const std::size_t first = mEntityNum;
 
-			if (mEntityNum + 1 >= mMaxEntityNum)
+			// 構築
+			constructRows(first, count);
+
+			// スロットを割り当てて行に登録
+			entities.reserve(entities.size() + count);
+			for (std::size_t row = first; row < first + count; ++row)
 			{
-				// DEBUG!!!!!!!!
-				//std::cerr << "plus realloc : " << mMaxEntityNum * 2 << "\n";
-				// メモリを再割り当てする
-				reallocate(mMaxEntityNum * 2);  // std::vectorの真似
+				const Entity entity = mpEntityTable->create(this, row);
+				mEntities.emplace_back(entity);
+				entities.emplace_back(entity);
 			}
 
 			// 更新
-			++mEntityNum;
-
-			return entity;
+			mEntityNum += count;
+			markAllChanged();
 		}
 
 		/**
 		 * @brief 指定したEntityを削除してメモリを詰める
 		 *
 		 * @param entity 削除するEntity
+		 * @param mode 行の詰め方
 		 */
-		virtual void deallocate(const Entity& entity) override
+		virtual void deallocate(const Entity& entity, RemovalMode mode = RemovalMode::SwapAndPop) override
 		{
-			std::size_t deallocatedIndex = entity.getID();
+			assert(mpEntityTable->getChunk(entity) == this || !"this entity is not in this chunk!");
+			const std::size_t deallocatedIndex = mpEntityTable->getRow(entity);
 
 			// 破棄
-			for (std::size_t i = 0; i < sizeof...(Args); ++i)
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
+			{
+				mArchetype.getTypeInfo(i).destruct(getAddress(i, deallocatedIndex));
+			}
+
+			mpEntityTable->release(entity);
+
+			removeRow(deallocatedIndex, mode);
+		}
+
+		/**
+		 * @brief 指定した複数の行のEntityをまとめて削除し、1回の走査でメモリを詰める
+		 * @details メモリの切り詰めの判定も1回だけ行われる
+		 * @param rows 削除する行(昇順・重複なし)
+		 * @param mode 行の詰め方
+		 */
+		virtual void deallocate(const std::vector<std::size_t>& rows, RemovalMode mode = RemovalMode::SwapAndPop) override
+		{
+			if (rows.empty())
 			{
-				// 書き込む型までのオフセット
-				const std::size_t offset = mArchetype.getTypeOffset(i, mMaxEntityNum);
+				return;
+			}
+
+			assert(std::is_sorted(rows.begin(), rows.end()) || !"rows must be sorted!");
+			assert(std::adjacent_find(rows.begin(), rows.end()) == rows.end() || !"rows must be unique!");
+			assert(rows.back() < mEntityNum || !"invalid row!");
 
-				std::byte* ptr = (mpMemory + offset + entity.getID() * mArchetype.getTypeSize(i));
+			// 破棄
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
+			{
+				destructRows(i, rows);
+			}
 
-				destruct<Args...>(mArchetype.getReverseTypeIndex(i), ptr);
+			for (const auto row : rows)
+			{
+				mpEntityTable->release(mEntities[row]);
 			}
 
-			// indexを削除
-			auto&& itr = std::remove_if(
-				mpEntityIDs.begin(),
-				mpEntityIDs.end(),
-				[&](std::size_t* pIndex)
+			const std::size_t newEntityNum = mEntityNum - rows.size();
+
+			// 移動元の行と移動先の行の組を作る
+			std::vector<std::pair<std::size_t, std::size_t>> moves;
+			if (mode == RemovalMode::SwapAndPop)
+			{
+				// 新しい末尾より前の穴を、新しい末尾以降の生存している行で埋める
+				std::size_t hole = 0;
+				std::size_t removed = std::lower_bound(rows.begin(), rows.end(), newEntityNum) - rows.begin();
+				for (std::size_t src = newEntityNum; src < mEntityNum; ++src)
 				{
-					if (*pIndex == deallocatedIndex)
+					if (removed < rows.size() && rows[removed] == src)
 					{
-						delete pIndex;
-						return true;
+						++removed;
+						continue;
 					}
-					else if (*pIndex > deallocatedIndex)
+
+					moves.emplace_back(src, rows[hole++]);
+				}
+			}
+			else
+			{
+				// 最初の穴以降の生存している行を順に前に詰める
+				std::size_t dst = rows.front();
+				std::size_t removed = 0;
+				for (std::size_t src = rows.front(); src < mEntityNum; ++src)
+				{
+					if (removed < rows.size() && rows[removed] == src)
 					{
-						--(*pIndex);
+						++removed;
+						continue;
 					}
 
-					return false;
-				});
-			mpEntityIDs.erase(itr, mpEntityIDs.end());
+					moves.emplace_back(src, dst++);
+				}
+			}
 
 			// 実際のメモリ領域を移動
-			if (mEntityNum > deallocatedIndex + 1)
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
 			{
-				std::byte* dst = nullptr, * src = nullptr;
-				std::size_t offset = 0;
-				for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
-				{
-					const auto&& typeSize = mArchetype.getTypeSize(i);
-					dst = mpMemory + offset + deallocatedIndex * typeSize;
-					src = dst + typeSize;  // 後ろに1つずらす
-					std::memmove(dst, src, (mEntityNum - deallocatedIndex - 1) * typeSize);
-					offset += typeSize * mMaxEntityNum;
-				}
+				moveRows(i, moves);
+			}
+
+			for (const auto& [src, dst] : moves)
+			{
+				mEntities[dst] = mEntities[src];
+				mpEntityTable->setLocation(mEntities[dst], this, dst);
 			}
 
+			mEntities.resize(newEntityNum);
+
 			// Entity数更新
-			--mEntityNum;
+			mEntityNum = newEntityNum;
+			markAllChanged();
 
-			// 1/3を切ってる場合はメモリを切り詰める
-			if (mEntityNum && mEntityNum < (mMaxEntityNum / 3) && mMaxEntityNum > 16)
+			// 閾値を切ってる場合はメモリを切り詰める(切り詰め後の容量を先に求めて1回で行う)
+			const std::size_t newMaxEntityNum = getShrunkEntityNum();
+			if (newMaxEntityNum != mMaxEntityNum)
 			{
-				// DEBUG!!!!!!!!!
-				//std::cerr << "minus realloc : " << mMaxEntityNum / 2 << "\n";
-
-				reallocate(mMaxEntityNum / 2);
+				reallocate(newMaxEntityNum);
 			}
 		}
 
 		/**
 		 * @brief Entityが増えたらメモリを割り当て直す
 		 *
-		 * @param maxEntityNum 新しい最大Entity数
+		 * @param requestedMaxEntityNum 新しい最大Entity数(AoSoAの場合はブロックの倍数に切り上げられる)
 		 */
-		virtual void reallocate(const std::size_t newMaxEntityNum) override
+		virtual void reallocate(const std::size_t requestedMaxEntityNum) override
 		{
-			assert(newMaxEntityNum != mMaxEntityNum);
+			const std::size_t newMaxEntityNum = getLayoutEntityNum(requestedMaxEntityNum);
+			if (newMaxEntityNum == mMaxEntityNum)
+			{
+				return;
+			}
+
 			assert(newMaxEntityNum >= mEntityNum);
+			assert(newMaxEntityNum != 0);
 
 			const auto oldMaxEntityNum = mMaxEntityNum;
 
+			if (mpMemory && newMaxEntityNum > oldMaxEntityNum)
+			{
+				++mReallocationStats.growCount;
+			}
+			else if (mpMemory)
+			{
+				++mReallocationStats.shrinkCount;
+			}
+
+			// 大きさを変更できるリソースでは、全コピーせずにメモリの大きさを変えて列の位置だけ直す
+			if (mpMemory && mpResizableMemoryResource && mArchetype.isTriviallyCopyable())
+			{
+				resizeColumns(oldMaxEntityNum, newMaxEntityNum);
+				return;
+			}
+
 			// 新メモリ割当て
-			auto&& newMemSize = mArchetype.getAllTypeSize() * newMaxEntityNum;
-			std::byte* newMem = new std::byte[mArchetype.getAllTypeSize() * newMaxEntityNum]();
-			std::memset(newMem, 0, newMemSize);
+			std::byte* newMem = allocateMemory(newMaxEntityNum);
 
-			{  // データ移行
-				std::size_t newOffset = 0, oldOffset = 0;
+			if (mpMemory)  // データ移行(破棄後の割り当て直しでは何もしない)
+			{
 				const auto&& typeCount = mArchetype.getTypeCount();
 				for (std::size_t i = 0; i < typeCount; ++i)
 				{
-					const auto&& typeSize = mArchetype.getTypeSize(i);
+					const TypeInfo& type = mArchetype.getTypeInfo(i);
 
-					// TODO: ここで全Entityに対してコピーコンストラクタを呼ぶ
-					if (isTriviallyCopyable<Args...>(mArchetype.getReverseTypeIndex(i)))
+					// 連続している行毎にまとめて移す(SoAなら列全体で1回、trivially copyableな型はmemmoveのみ)
+					for (std::size_t row = 0; row < mEntityNum;)
 					{
-						memcpy(newMem + newOffset, mpMemory + oldOffset, typeSize * mEntityNum);
+						const std::size_t num = getContiguousEntityNum(row, mEntityNum - row);
+						type.relocate(getAddress(i, row), getAddress(newMem, newMaxEntityNum, i, row), num);
+						row += num;
 					}
-					else
-					{
-						for (const auto pEntity : mpEntityIDs)
-						{
-							std::byte* pSrc = mpMemory + oldOffset + *pEntity * typeSize;
-							std::byte* pDst = newMem + newOffset + *pEntity * typeSize;
-
-							copyConstruct<Args...>(mArchetype.getReverseTypeIndex(i), pSrc, pDst);
-						}
-					}
-
-					newOffset += typeSize * newMaxEntityNum;
-					oldOffset += typeSize * oldMaxEntityNum;
+					mReallocationStats.copiedBytes += type.getSize() * mEntityNum;
 				}
 			}
 
 			// アドレス移行
-			delete[] mpMemory;
+			if (mpMemory)
+			{
+				deallocateMemory(mpMemory, oldMaxEntityNum);
+			}
 			mpMemory = newMem;
 
 			mMaxEntityNum = newMaxEntityNum;
+			updateColumns();
 		}
 
 		/**
@@ -287,210 +379,359 @@ namespace mvecs
 		 */
 		virtual void destroy()
 		{
-			if (!mpMemory || mpEntityIDs.empty())
+			if (!mpMemory)
 			{
 				return;
 			}
 
 			// ここで全ComponentDataに対してデストラクタを呼ぶ
-			for (std::size_t i = 0; i < sizeof...(Args); ++i)
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
 			{
-				// 書き込む型までのオフセット
-				const std::size_t offset = mArchetype.getTypeOffset(i, mMaxEntityNum);
+				const TypeInfo& type = mArchetype.getTypeInfo(i);
+				if (type.isTriviallyDestructible())
+				{
+					continue;
+				}
 
-				for (const auto pEntity : mpEntityIDs)
+				// 連続している行毎にまとめて破棄する
+				for (std::size_t row = 0; row < mEntityNum;)
 				{
-					std::byte* ptr = mpMemory + offset + *pEntity * mArchetype.getTypeSize(i);
-					destruct<Args...>(mArchetype.getReverseTypeIndex(i), ptr);
+					const std::size_t num = getContiguousEntityNum(row, mEntityNum - row);
+					type.destruct(getAddress(i, row), num);
+					row += num;
 				}
 			}
 
-			delete[] mpMemory;
+			deallocateMemory(mpMemory, mMaxEntityNum);
 			mpMemory = nullptr;
+			mMaxEntityNum = 0;
+			updateColumns();
 
-			for (auto p : mpEntityIDs)
+			// 破棄したEntityのスロットを解放
+			for (const auto& entity : mEntities)
 			{
-				delete p;
+				mpEntityTable->release(entity);
 			}
 
-			mpEntityIDs.clear();
+			mEntities.clear();
+			mEntityNum = 0;
 		}
 
 		/**
-		 * @brief entityをotherのChunkに移動する
-		 *
-		 * @param other 移動先Chunk
+		 * @brief entityの行をotherのChunkに移動する(ComponentDataの追加・削除に使う)
+		 * @details 共通する型は列毎に移動先にムーブし、otherに無い型は破棄する otherにしか無い型はデフォルト構築される
+		 *          Entityはそのままで、EntityTable上の位置のみ更新される
+		 * @param entity 移動するEntity
+		 * @param other 移動先Chunk(ページの場合は満杯でないこと)
+		 * @param mode 移動元の行の詰め方
 		 */
-		Entity moveTo(const Entity& entity, IChunk& other)
+		virtual void moveTo(const Entity& entity, IChunk& other, RemovalMode mode = RemovalMode::SwapAndPop) override
 		{
-			const std::size_t srcIndex = entity.getID();
+			assert(mpEntityTable->getChunk(entity) == this || !"this entity is not in this chunk!");
+			assert(&other != this);
 
-			// 移動先Entityをallocate
-			Entity rtn = other.allocate();
-			const std::size_t dstIndex = rtn.getID();
+			const std::size_t srcRow = mpEntityTable->getRow(entity);
 
-			std::byte* dst = nullptr, * src = nullptr;
-			std::size_t dstOffset = 0, srcOffset = 0;
-			std::size_t size = 0;
-			if (mArchetype.getAllTypeSize() < other.mArchetype.getAllTypeSize())  // 移動元 < 移動先
+			// 移動先の行を確保(共通しない型のみ構築される)
+			const std::size_t dstRow = other.allocateForMove(entity, mArchetype);
+
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
 			{
-				for (std::size_t i = 0; i < sizeof...(Args); ++i)
+				const TypeInfo& type = mArchetype.getTypeInfo(i);
+				std::byte* pSrc = getAddress(i, srcRow);
+
+				if (other.mArchetype.isIn(type.getHash()))
+				{
+					type.relocate(pSrc, other.getAddress(other.mArchetype.getTypeIndex(type.getHash()), dstRow));
+				}
+				else
 				{
-					srcOffset = mArchetype.getTypeOffset(i, mMaxEntityNum);
-					dstOffset = other.mArchetype.getTypeOffset(other.mArchetype.getTypeIndex(mArchetype.getTypeHash(i)), other.mMaxEntityNum);
+					type.destruct(pSrc);
+				}
+			}
 
-					size = mArchetype.getTypeSize(i);
-					dst = other.mpMemory + dstOffset + dstIndex * size;
-					src = mpMemory + srcOffset + srcIndex * size;
+			removeRow(srcRow, mode);
+		}
 
-					if (isTriviallyCopyable(i))
-					{
-						std::memcpy(dst, src, size * mEntityNum);
-					}
-					else
-					{
-						// 書き込む型までのオフセット
-						for (const auto pEntity : mpEntityIDs)
-						{
-							std::byte* pSrc = src + *pEntity * size;
-							std::byte* pDst = dst + *pEntity * size;
-
-							copyConstruct<Args...>(i, pSrc, pDst);
-						}
-					}
+		/**
+		 * @brief 他のChunkから移動してくるEntityの行を確保する(moveToから呼ばれる)
+		 * @details srcArchetypeに無い型のみデフォルト構築され、共通する型は移動元がムーブ構築する
+		 * @param entity 移動してくるEntity(EntityTable上の位置はこのChunkに更新される)
+		 * @param srcArchetype 移動元のArchetype
+		 * @return std::size_t 確保した行
+		 */
+		virtual std::size_t allocateForMove(const Entity& entity, const Archetype& srcArchetype) override
+		{
+			if (mEntityNum >= mMaxEntityNum)
+			{
+				reallocate(getGrownEntityNum(mEntityNum + 1));
+			}
 
+			const std::size_t row = mEntityNum;
 
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
+			{
+				const TypeInfo& type = mArchetype.getTypeInfo(i);
+				if (!srcArchetype.isIn(type.getHash()))
+				{
+					type.construct(getAddress(i, row), 1);
 				}
 			}
-			else  // 移動元 >= 移動先
+
+			mEntities.emplace_back(entity);
+			mpEntityTable->setLocation(entity, this, row);
+
+			++mEntityNum;
+			markAllChanged();
+
+			return row;
+		}
+
+	private:
+
+		/**
+		 * @brief 破棄済み(もしくは移動済み)の行を詰めてEntity数を減らす
+		 * @details 閾値を切っている場合はメモリを切り詰める
+		 * @param row 破棄済みの行
+		 * @param mode 行の詰め方
+		 */
+		void removeRow(const std::size_t row, RemovalMode mode)
+		{
+			if (mode == RemovalMode::SwapAndPop)
+			{
+				swapAndPop(row);
+			}
+			else
 			{
-				for (std::size_t i = 0; i < other.mArchetype.getTypeCount(); ++i)
-				{
-					srcOffset = other.mArchetype.getTypeOffset(other.mArchetype.getTypeIndex(mArchetype.getTypeHash(i)), other.mMaxEntityNum);
-					dstOffset = mArchetype.getTypeOffset(i, mMaxEntityNum);
+				shiftDown(row);
+			}
 
-					size = mArchetype.getTypeSize(i);
-					dst = mpMemory + srcOffset + srcIndex * size;
-					src = other.mpMemory + dstOffset + dstIndex * size;
+			// Entity数更新
+			--mEntityNum;
+			markAllChanged();
 
-					if (isTriviallyCopyable(i))
-					{
-						std::memcpy(dst, src, size * mEntityNum);
-					}
-					else
-					{
-						// 書き込む型までのオフセット
-						for (const auto pEntity : mpEntityIDs)
-						{
-							std::byte* pSrc = src + *pEntity * size;
-							std::byte* pDst = dst + *pEntity * size;
-
-							copyConstruct<Args...>(i, pSrc, pDst);
-						}
-					}
-				}
+			// 閾値を切ってる場合はメモリを切り詰める
+			const std::size_t newMaxEntityNum = getShrunkEntityNum();
+			if (newMaxEntityNum != mMaxEntityNum)
+			{
+				reallocate(newMaxEntityNum);
 			}
+		}
 
-			return rtn;
+		/**
+		 * @brief requiredEntityNum個のEntityを保持するために割り当てる最大Entity数を求める
+		 * @details ページの場合は容量が固定なので、破棄後に割り当て直す時のみ呼ばれる
+		 * @param requiredEntityNum 必要なEntity数
+		 * @return std::size_t 新しい最大Entity数
+		 */
+		std::size_t getGrownEntityNum(const std::size_t requiredEntityNum) const
+		{
+			if (mStorageMode == StorageMode::Paged)
+			{
+				assert(requiredEntityNum <= mPageEntityNum || !"this page is full!");
+				return mPageEntityNum;
+			}
+
+			// std::vectorの真似(倍率はCapacityPolicyで決まる)
+			const auto grownEntityNum = static_cast<std::size_t>(std::ceil(mMaxEntityNum * mCapacityPolicy.growthFactor));
+			return std::max({grownEntityNum, mMaxEntityNum + 1, requiredEntityNum});
 		}
 
-	private:
+		/**
+		 * @brief 現在のEntity数に対して切り詰めた後の最大Entity数を求める
+		 * @details 容量の1/growthFactor倍を繰り返し、shrinkThreshold倍がEntity数以下になるまで切り詰める
+		 *          minEntityNumとreserveした容量は下回らない、ページとneverShrinkの場合は切り詰めない
+		 * @return std::size_t 新しい最大Entity数(切り詰めない場合は現在の最大Entity数)
+		 */
+		std::size_t getShrunkEntityNum() const
+		{
+			if (mStorageMode == StorageMode::Paged || mCapacityPolicy.neverShrink || mEntityNum == 0)
+			{
+				return mMaxEntityNum;
+			}
+
+			const std::size_t minEntityNum = std::max({mCapacityPolicy.minEntityNum, mReservedEntityNum, mEntityNum});
+
+			std::size_t newMaxEntityNum = mMaxEntityNum;
+			while (newMaxEntityNum > minEntityNum && mEntityNum < newMaxEntityNum * mCapacityPolicy.shrinkThreshold)
+			{
+				// 係数が1に近くても必ず1以上減らす
+				const auto shrunkEntityNum = static_cast<std::size_t>(newMaxEntityNum / mCapacityPolicy.growthFactor);
+				newMaxEntityNum = std::max(std::min(shrunkEntityNum, newMaxEntityNum - 1), minEntityNum);
+			}
+
+			return newMaxEntityNum;
+		}
 
 		/**
-		 * @brief このアドレスに指定した型を配置newする
+		 * @brief 末尾の行を破棄済みの行に移動し、移動したEntityの位置だけを更新する
 		 *
-		 * @param typeIndex Args...の何番目の型か(Archetype::getReverseTypeIndex()を用いる)
-		 * @param ptr 配置newされるアドレス
+		 * @param deallocatedIndex 破棄済みの行
 		 */
-		template<typename Head, typename... Tail>
-		constexpr void construct(std::size_t typeIndex, std::byte* ptr)
+		void swapAndPop(const std::size_t deallocatedIndex)
 		{
+			const std::size_t lastIndex = mEntityNum - 1;
 
-			if (typeIndex == sizeof...(Args) - sizeof...(Tail) - 1)
+			if (deallocatedIndex != lastIndex)
 			{
-				if constexpr (!std::is_trivially_constructible_v<Head>)
+				for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
 				{
-					new(ptr) Head();
+					mArchetype.getTypeInfo(i).relocate(getAddress(i, lastIndex), getAddress(i, deallocatedIndex));
 				}
 
-				return;
+				mEntities[deallocatedIndex] = mEntities[lastIndex];
+				mpEntityTable->setLocation(mEntities[deallocatedIndex], this, deallocatedIndex);
 			}
 
-			if constexpr (sizeof...(Tail) > 0)
-			{
-				construct<Tail...>(typeIndex, ptr);
-			}
+			mEntities.pop_back();
 		}
 
 		/**
-		 * @brief このアドレスで指定した型のデストラクタを呼ぶ
-		 * 
-		 * @param typeIndex Args...の何番目の型か(Archetype::getReverseTypeIndex()を用いる)
-		 * @param ptr
+		 * @brief メモリの大きさを変更し、各列を新しいオフセットに移す(全ての型がtrivially copyableな場合のみ)
+		 *
+		 * @param oldMaxEntityNum 現在の最大Entity数
+		 * @param newMaxEntityNum 新しい最大Entity数
 		 */
-		template<typename Head, typename... Tail>
-		constexpr void destruct(std::size_t typeIndex, std::byte* ptr)
+		void resizeColumns(const std::size_t oldMaxEntityNum, const std::size_t newMaxEntityNum)
 		{
+			const std::size_t typeCount = mArchetype.getTypeCount();
 
-			if (typeIndex == sizeof...(Args) - sizeof...(Tail) - 1)
+			if (mColumnLayout == ColumnLayout::AoSoA)
 			{
-				if constexpr (!std::is_trivially_destructible_v<Head>)
+				// ブロックの位置は最大Entity数に依らないので移動は不要
+				mpMemory = resizeMemory(mpMemory, oldMaxEntityNum, newMaxEntityNum);
+			}
+			else if (newMaxEntityNum < oldMaxEntityNum)
+			{
+				// 縮める場合は前の列から詰めた後に切り詰める
+				for (std::size_t i = 1; i < typeCount; ++i)
 				{
-					reinterpret_cast<Head*>(ptr)->~Head();
+					std::memmove(mpMemory + mArchetype.getTypeOffset(i, newMaxEntityNum), mpMemory + mArchetype.getTypeOffset(i, oldMaxEntityNum), mArchetype.getTypeSize(i) * mEntityNum);
+					mReallocationStats.copiedBytes += mArchetype.getTypeSize(i) * mEntityNum;
 				}
 
-				return;
+				mpMemory = resizeMemory(mpMemory, oldMaxEntityNum, newMaxEntityNum);
 			}
-
-			if constexpr (sizeof...(Tail) > 0)
+			else
 			{
-				destruct<Tail...>(typeIndex, ptr);
+				// 伸ばす場合は伸ばした後に後ろの列から移す
+				mpMemory = resizeMemory(mpMemory, oldMaxEntityNum, newMaxEntityNum);
+
+				for (std::size_t i = typeCount; i-- > 1;)
+				{
+					std::memmove(mpMemory + mArchetype.getTypeOffset(i, newMaxEntityNum), mpMemory + mArchetype.getTypeOffset(i, oldMaxEntityNum), mArchetype.getTypeSize(i) * mEntityNum);
+					mReallocationStats.copiedBytes += mArchetype.getTypeSize(i) * mEntityNum;
+				}
 			}
+
+			mMaxEntityNum = newMaxEntityNum;
+			updateColumns();
 		}
 
 		/**
-		 * @brief srcからdstへ指定した型でのコピーを行う
-		 * 
-		 * @param typeIndex Args...の何番目の型か(Archetype::getReverseTypeIndex()を用いる)
-		 * @param src コピー元アドレス
-		 * @param dst コピー先アドレス
+		 * @brief 破棄済みの行より後ろの行を全て1つ前にずらす
+		 *
+		 * @param deallocatedIndex 破棄済みの行
 		 */
-		template<typename Head, typename... Tail>
-		constexpr void copyConstruct(std::size_t typeIndex, std::byte* src, std::byte* dst)
+		void shiftDown(const std::size_t deallocatedIndex)
 		{
-			if (typeIndex == sizeof...(Args) - sizeof...(Tail) - 1)
+			// 後ろの行のEntityの位置を1つ前にずらす
+			mEntities.erase(mEntities.begin() + deallocatedIndex);
+			for (std::size_t row = deallocatedIndex; row < mEntities.size(); ++row)
 			{
-				new(dst) Head(std::move(*reinterpret_cast<Head*>(src)));
+				mpEntityTable->setLocation(mEntities[row], this, row);
+			}
 
-				return;
+			// 実際のメモリ領域を移動(前の行から順に1つ前にずらす)
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
+			{
+				const TypeInfo& type = mArchetype.getTypeInfo(i);
+
+				for (std::size_t row = deallocatedIndex; row + 1 < mEntityNum;)
+				{
+					// 移動元と移動先がどちらも連続している行をまとめてずらす(AoSoAのブロックの境界では1行ずつ)
+					const std::size_t rest = mEntityNum - 1 - row;
+					const std::size_t num = std::min(getContiguousEntityNum(row, rest), getContiguousEntityNum(row + 1, rest));
+					type.relocate(getAddress(i, row + 1), getAddress(i, row), num);
+					row += num;
+				}
 			}
+		}
 
-			if constexpr (sizeof...(Tail) > 0)
+		/**
+		 * @brief [first, first + count)の行の全ComponentDataを列毎にまとめて構築する
+		 *
+		 * @param first 先頭の行
+		 * @param count 行数
+		 */
+		void constructRows(const std::size_t first, const std::size_t count)
+		{
+			for (std::size_t i = 0; i < mArchetype.getTypeCount(); ++i)
 			{
-				copyConstruct<Tail...>(typeIndex, src, dst);
+				// 連続している行毎にまとめて構築する(SoAなら列全体で1回)
+				for (std::size_t row = first; row < first + count;)
+				{
+					const std::size_t num = getContiguousEntityNum(row, first + count - row);
+					mArchetype.getTypeInfo(i).construct(getAddress(i, row), num);
+					row += num;
+				}
 			}
 		}
 
 		/**
-		 * @brief その型がtrivially_copyableかどうか判定する
-		 * 
-		 * @param typeIndex Args...の何番目の型か(Archetype::getReverseTypeIndex()を用いる)
-		 * @return trivially_copyableかどうか
+		 * @brief 列中の指定した行の要素をまとめて破棄する
+		 *
+		 * @param column Archetype上での型の添字
+		 * @param rows 行
 		 */
-		template<typename Head, typename... Tail>
-		constexpr bool isTriviallyCopyable(std::size_t typeIndex)
+		void destructRows(std::size_t column, const std::vector<std::size_t>& rows)
 		{
-			if (typeIndex == sizeof...(Args) - sizeof...(Tail) - 1)
+			const TypeInfo& type = mArchetype.getTypeInfo(column);
+			if (type.isTriviallyDestructible())
 			{
-				return std::is_trivially_copyable_v<Head>;
+				return;
 			}
 
-			if constexpr (sizeof...(Tail) > 0)
+			// 連続している行をまとめて破棄する
+			for (std::size_t j = 0; j < rows.size();)
 			{
-				isTriviallyCopyable<Tail...>(typeIndex);
+				std::size_t num = 1;
+				const std::size_t contiguousNum = getContiguousEntityNum(rows[j], rows.size() - j);
+				while (num < contiguousNum && rows[j + num] == rows[j] + num)
+				{
+					++num;
+				}
+
+				type.destruct(getAddress(column, rows[j]), num);
+				j += num;
 			}
+		}
+
+		/**
+		 * @brief 列中の要素を(移動元の行, 移動先の行)の組に従ってまとめて移動する
+		 * @details 移動先は破棄済みであること、移動元は移動後に破棄される
+		 * @param column Archetype上での型の添字
+		 * @param moves (移動元の行, 移動先の行)の組
+		 */
+		void moveRows(std::size_t column, const std::vector<std::pair<std::size_t, std::size_t>>& moves)
+		{
+			const TypeInfo& type = mArchetype.getTypeInfo(column);
 
-			return false;
+			// 移動元・移動先がどちらも連続している組をまとめて移す(移動先は常に移動元より前なので前から順に移せる)
+			for (std::size_t j = 0; j < moves.size();)
+			{
+				const auto [src, dst] = moves[j];
+				const std::size_t contiguousNum = std::min(getContiguousEntityNum(src, moves.size() - j), getContiguousEntityNum(dst, moves.size() - j));
+
+				std::size_t num = 1;
+				while (num < contiguousNum && moves[j + num].first == src + num && moves[j + num].second == dst + num)
+				{
+					++num;
+				}
+
+				type.relocate(getAddress(column, src), getAddress(column, dst), num);
+				j += num;
+			}
 		}
 
 	};
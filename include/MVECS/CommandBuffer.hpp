@@ -0,0 +1,355 @@
+#ifndef MVECS_MVECS_COMMANDBUFFER_HPP_
+#define MVECS_MVECS_COMMANDBUFFER_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Archetype.hpp"
+#include "Entity.hpp"
+#include "IComponentData.hpp"
+
+namespace mvecs
+{
+    template <typename Key, typename Common>
+    class World;
+
+    /**
+     * @brief Entityの構築・破棄とComponentDataの書き込みを記録し、後でまとめて実行する
+     * @details forEach中やforEachParallelのスレッド内など、Chunkの構造を変更できない場所で使う
+     *          スレッド毎に別のCommandBufferを使うこと(World::getCommandBufferで取得できる)
+     * @tparam Key Worldのキーの型
+     * @tparam Common 共有領域の型
+     */
+    template <typename Key, typename Common>
+    class CommandBuffer
+    {
+    public:
+        /**
+         * @brief コンストラクタ
+         *
+         */
+        CommandBuffer()
+            : mBlockIndex(0)
+            , mBlockUsed(0)
+        {
+        }
+
+        /**
+         * @brief デストラクタ
+         *
+         */
+        ~CommandBuffer()
+        {
+            clear();
+
+            for (const auto& [pBlock, size] : mBlocks)
+            {
+                ::operator delete(pBlock, size, std::align_val_t(PayloadAlignment));
+            }
+        }
+
+        /**
+         * @brief コピーコンストラクタはdelete
+         *
+         * @param src
+         */
+        CommandBuffer(const CommandBuffer& src) = delete;
+
+        /**
+         * @brief 代入によるコピーもdelete
+         *
+         * @param src
+         * @return CommandBuffer&
+         */
+        CommandBuffer& operator=(const CommandBuffer& src) = delete;
+
+        /**
+         * @brief Entityの構築を記録する(ComponentDataはデフォルト構築される)
+         *
+         * @tparam Args Entityが持つComponentData
+         */
+        template <typename... Args>
+        void createEntity()
+        {
+            mCreates.emplace_back(CreateCommand{&playCreate<Args...>, nullptr});
+        }
+
+        /**
+         * @brief 初期値付きでEntityの構築を記録する
+         *
+         * @tparam Args Entityが持つComponentData
+         * @param values 各ComponentDataの初期値
+         */
+        template <typename... Args>
+        void createEntity(const Args&... values)
+        {
+            using Payload = std::tuple<Args...>;
+            void* pPayload = store(Payload(values...));
+            mCreates.emplace_back(CreateCommand{&playCreate<Args...>, pPayload});
+        }
+
+        /**
+         * @brief Entityの破棄を記録する
+         *
+         * @param entity 破棄するEntity
+         */
+        void destroyEntity(const Entity& entity)
+        {
+            mDestroyed.emplace_back(entity);
+        }
+
+        /**
+         * @brief ComponentDataの書き込みを記録する
+         * @details 実行時にEntityが破棄済み、もしくはその型を持たない場合は無視される
+         * @tparam T 書き込むComponentDataの型
+         * @param entity 書き込み先Entity
+         * @param value 書き込む値
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        void setComponentData(const Entity& entity, const T& value)
+        {
+            void* pPayload = store(value);
+            mWrites.emplace_back(WriteCommand{entity, &playWrite<T>, pPayload});
+        }
+
+        /**
+         * @brief 何も記録されていないかどうか
+         *
+         * @return true 空
+         * @return false 記録がある
+         */
+        bool empty() const
+        {
+            return mCreates.empty() && mDestroyed.empty() && mWrites.empty();
+        }
+
+        /**
+         * @brief 記録された書き込みをEntity毎にまとめて実行する(同じEntityへの書き込みは記録順)
+         *
+         * @param world 実行先World
+         */
+        void playbackWrites(World<Key, Common>& world)
+        {
+            std::stable_sort(mWrites.begin(), mWrites.end(), [](const WriteCommand& left, const WriteCommand& right)
+                             { return left.entity.getIndex() < right.entity.getIndex(); });
+
+            for (const auto& write : mWrites)
+            {
+                write.play(world, write.entity, write.pPayload);
+            }
+        }
+
+        /**
+         * @brief 記録された破棄対象を追加する(複数のCommandBufferの破棄をまとめて実行するため)
+         *
+         * @param entities 追加先
+         */
+        void appendDestroyed(std::vector<Entity>& entities) const
+        {
+            entities.insert(entities.end(), mDestroyed.begin(), mDestroyed.end());
+        }
+
+        /**
+         * @brief 記録された構築をArchetype毎にまとめて実行する
+         *
+         * @param world 実行先World
+         */
+        void playbackCreates(World<Key, Common>& world)
+        {
+            std::stable_sort(mCreates.begin(), mCreates.end(), [](const CreateCommand& left, const CreateCommand& right)
+                             { return std::less<CreateFunc>()(left.play, right.play); });
+
+            for (std::size_t begin = 0; begin < mCreates.size();)
+            {
+                std::size_t end = begin + 1;
+                while (end < mCreates.size() && mCreates[end].play == mCreates[begin].play)
+                {
+                    ++end;
+                }
+
+                mCreates[begin].play(world, mCreates.data() + begin, end - begin);
+                begin = end;
+            }
+        }
+
+        /**
+         * @brief 記録を全て破棄する(確保済みのメモリは再利用のため保持する)
+         *
+         */
+        void clear()
+        {
+            for (const auto& [destroy, pPayload] : mPayloadDestructors)
+            {
+                destroy(pPayload);
+            }
+
+            mPayloadDestructors.clear();
+            mCreates.clear();
+            mDestroyed.clear();
+            mWrites.clear();
+
+            mBlockIndex = 0;
+            mBlockUsed  = 0;
+        }
+
+    private:
+        struct CreateCommand;
+
+        //! 同じArchetypeの構築コマンドをまとめて実行する関数
+        using CreateFunc = void (*)(World<Key, Common>&, const CreateCommand*, std::size_t);
+        //! 書き込みコマンドを実行する関数
+        using WriteFunc = void (*)(World<Key, Common>&, const Entity&, const void*);
+        //! 記録した値を破棄する関数
+        using DestroyFunc = void (*)(void*);
+
+        /**
+         * @brief 構築コマンド
+         *
+         */
+        struct CreateCommand
+        {
+            //! Archetype毎の実行関数(Archetypeの識別にも使う)
+            CreateFunc play;
+            //! 初期値(std::tuple<Args...>, 無い場合はnullptr)
+            void* pPayload;
+        };
+
+        /**
+         * @brief 書き込みコマンド
+         *
+         */
+        struct WriteCommand
+        {
+            //! 書き込み先Entity
+            Entity entity;
+            //! 型毎の実行関数
+            WriteFunc play;
+            //! 書き込む値
+            void* pPayload;
+        };
+
+        //! 値を記録するメモリブロックの最小サイズ
+        static constexpr std::size_t PayloadBlockSize = 4096;
+        //! 値を記録するメモリブロックのアラインメント(ComponentDataの列と同じ)
+        static constexpr std::size_t PayloadAlignment = Archetype::ColumnAlignment;
+
+        /**
+         * @brief 同じArchetypeのEntityをまとめて構築し、初期値を書き込む
+         *
+         * @tparam Args Entityが持つComponentData
+         * @param world 実行先World
+         * @param pCommands 構築コマンドの先頭
+         * @param count 構築コマンド数
+         */
+        template <typename... Args>
+        static void playCreate(World<Key, Common>& world, const CreateCommand* pCommands, std::size_t count)
+        {
+            const std::vector<Entity> entities = world.template createEntities<Args...>(count);
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (pCommands[i].pPayload)
+                {
+                    auto& values = *static_cast<std::tuple<Args...>*>(pCommands[i].pPayload);
+                    ((world.template getComponentData<Args>(entities[i]) = std::get<Args>(values)), ...);
+                }
+            }
+        }
+
+        /**
+         * @brief 記録した値を書き込む
+         *
+         * @tparam T ComponentDataの型
+         * @param world 実行先World
+         * @param entity 書き込み先Entity
+         * @param pPayload 書き込む値
+         */
+        template <typename T>
+        static void playWrite(World<Key, Common>& world, const Entity& entity, const void* pPayload)
+        {
+            if (world.isAlive(entity) && world.template hasComponentData<T>(entity))
+            {
+                world.template getComponentData<T>(entity) = *static_cast<const T*>(pPayload);
+            }
+        }
+
+        /**
+         * @brief 値をメモリブロックに記録する(記録した値のアドレスはclearまで変わらない)
+         *
+         * @tparam T 値の型
+         * @param value 値
+         * @return void* 記録先アドレス
+         */
+        template <typename T>
+        void* store(T&& value)
+        {
+            using U = std::decay_t<T>;
+            static_assert(alignof(U) <= PayloadAlignment, "over-aligned type can not be recorded");
+
+            std::size_t offset = (mBlockUsed + alignof(U) - 1) & ~(alignof(U) - 1);
+            if (mBlockIndex >= mBlocks.size() || offset + sizeof(U) > mBlocks[mBlockIndex].second)
+            {
+                // 次のブロックへ(足りなければ確保する)
+                if (mBlockIndex < mBlocks.size() && mBlockUsed != 0)
+                {
+                    ++mBlockIndex;
+                }
+
+                while (mBlockIndex < mBlocks.size() && mBlocks[mBlockIndex].second < sizeof(U))
+                {
+                    ++mBlockIndex;
+                }
+
+                if (mBlockIndex >= mBlocks.size())
+                {
+                    const std::size_t size = std::max(PayloadBlockSize, sizeof(U));
+                    mBlocks.emplace_back(static_cast<std::byte*>(::operator new(size, std::align_val_t(PayloadAlignment))), size);
+                    mBlockIndex = mBlocks.size() - 1;
+                }
+
+                offset = 0;
+            }
+
+            void* ptr  = mBlocks[mBlockIndex].first + offset;
+            mBlockUsed = offset + sizeof(U);
+
+            new (ptr) U(std::forward<T>(value));
+
+            if constexpr (!std::is_trivially_destructible_v<U>)
+            {
+                mPayloadDestructors.emplace_back([](void* p)
+                                                 { static_cast<U*>(p)->~U(); },
+                                                 ptr);
+            }
+
+            return ptr;
+        }
+
+        //! 構築コマンドたち
+        std::vector<CreateCommand> mCreates;
+        //! 破棄するEntityたち
+        std::vector<Entity> mDestroyed;
+        //! 書き込みコマンドたち
+        std::vector<WriteCommand> mWrites;
+
+        //! 値を記録するメモリブロック(先頭アドレス, サイズ)
+        std::vector<std::pair<std::byte*, std::size_t>> mBlocks;
+        //! 使用中のブロック
+        std::size_t mBlockIndex;
+        //! 使用中のブロックで使用済みのバイト数
+        std::size_t mBlockUsed;
+        //! 破棄が必要な記録済みの値
+        std::vector<std::pair<DestroyFunc, void*>> mPayloadDestructors;
+    };
+}  // namespace mvecs
+
+#endif
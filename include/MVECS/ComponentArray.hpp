@@ -1,17 +1,35 @@
 #ifndef MVECS_MVECS_COMPONENTARRAY_HPP_
 #define MVECS_MVECS_COMPONENTARRAY_HPP_
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <type_traits>
 
 #include "IComponentData.hpp"
 #include "TypeInfo.hpp"
 
+/**
+ * @brief ポインタが他のポインタと同じ領域を指さないことをコンパイラに伝える修飾子
+ * @details Chunkの異なる列(異なるComponentData型)のブロックは重ならないため、forEachChunkで受け取った配列から
+ *          取り出したポインタにはこれを付けてよい(ベクトル化の妨げになる別名の考慮を省ける)
+ *          戻り値の修飾は呼び出し側に伝わらないので、ポインタを受け取る変数・引数に付ける(forEachは内部のブロックのポインタに付けている)
+ */
+#if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+#define MVECS_RESTRICT __restrict
+#else
+#define MVECS_RESTRICT
+#endif
+
 namespace mvecs
 {
     /**
      * @brief Chunk上のComponentData型のアドレスを配列のように見せる
-     *
+     * @details Chunkの列の並べ方がAoSoAの場合、要素はブロック毎にしか連続していない
+     *          イテレータ(ポインタ)は全要素が連続している場合(SoA)のみ使える
+     *          AoSoAの場合はgetBlockNum・getBlockでブロック毎に辿る(SoAの場合は全体が1つのブロックになるので同じ書き方で両方に対応できる)
      * @tparam T ComponentData型
      * @tparam typename ComponentData型判定用
      */
@@ -27,7 +45,7 @@ namespace mvecs
         using reverse_iterator = std::reverse_iterator<iterator>;
 
         /**
-         * @brief コンストラクタ
+         * @brief コンストラクタ(全要素が連続している場合)
          *
          * @param address ComponentArrayを構築するアドレス
          * @param size 配列の要素数
@@ -35,11 +53,39 @@ namespace mvecs
         ComponentArray(T* address, std::size_t size)
             : mAddress(address)
             , mSize(size)
+            , mBlockEntityNum(0)
+            , mBlockShift(0)
+            , mBlockStride(0)
         {
             static_assert(IsComponentDataType<T>, "T is not ComponentData type");
             assert(address);
         }
 
+        /**
+         * @brief コンストラクタ(blockEntityNum個ずつのブロックがblockStrideバイト毎に並んでいる場合)
+         *
+         * @param address 先頭のブロックの先頭アドレス
+         * @param size 配列の要素数
+         * @param blockEntityNum 1ブロックあたりの要素数(2の冪)
+         * @param blockStride ブロックの間隔(バイト)
+         */
+        ComponentArray(T* address, std::size_t size, std::size_t blockEntityNum, std::size_t blockStride)
+            : mAddress(address)
+            , mSize(size)
+            , mBlockEntityNum(blockEntityNum)
+            , mBlockShift(0)
+            , mBlockStride(blockStride)
+        {
+            static_assert(IsComponentDataType<T>, "T is not ComponentData type");
+            assert(address);
+            assert((blockEntityNum != 0 && (blockEntityNum & (blockEntityNum - 1)) == 0) || !"block entity num must be a power of 2!");
+
+            while ((std::size_t(1) << mBlockShift) < blockEntityNum)
+            {
+                ++mBlockShift;
+            }
+        }
+
         /**
          * @brief []のオーバーロード(添字アクセスできるようにする)
          *
@@ -49,7 +95,7 @@ namespace mvecs
         T& operator[](const std::size_t index)
         {
             assert(index < mSize);
-            return *(mAddress + index);
+            return *getPointer(index);
         }
 
         /**
@@ -57,83 +103,180 @@ namespace mvecs
          *
          * @return std::size_t 要素数
          */
-        std::size_t size()
+        std::size_t size() const
         {
             return mSize;
         }
 
         /**
-         * @brief 先頭イテレータを取得する
-         * 
-         * @return iterator 
+         * @brief 先頭アドレスを取得する(全要素が連続している場合のみ)
+         *
+         * @return T* 先頭アドレス
+         */
+        T* data() const
+        {
+            assert(isContiguous() || !"the array is not contiguous! use getBlock");
+            return mAddress;
+        }
+
+        /**
+         * @brief 全要素がメモリ上で連続しているかどうか(SoAの場合)
+         *
+         * @return true 連続している
+         * @return false ブロック毎にしか連続していない
+         */
+        bool isContiguous() const
+        {
+            return mBlockEntityNum == 0;
+        }
+
+        /**
+         * @brief 1ブロックあたりの要素数を取得する(連続している場合は要素数)
+         *
+         * @return std::size_t 要素数
+         */
+        std::size_t getBlockEntityNum() const
+        {
+            return isContiguous() ? mSize : mBlockEntityNum;
+        }
+
+        /**
+         * @brief ブロック数を取得する
+         *
+         * @return std::size_t ブロック数
+         */
+        std::size_t getBlockNum() const
+        {
+            if (isContiguous())
+            {
+                return mSize == 0 ? 0 : 1;
+            }
+
+            return (mSize + mBlockEntityNum - 1) >> mBlockShift;
+        }
+
+        /**
+         * @brief ブロックの先頭アドレスを取得する(ブロック内の要素はポインタで連続して扱える)
+         *
+         * @param blockIndex ブロックの添字
+         * @return T* 先頭アドレス
+         */
+        T* getBlock(const std::size_t blockIndex) const
+        {
+            assert(blockIndex < getBlockNum());
+            return getPointer(blockIndex * getBlockEntityNum());
+        }
+
+        /**
+         * @brief ブロック内の要素数を取得する(最後のブロックのみ少ないことがある)
+         *
+         * @param blockIndex ブロックの添字
+         * @return std::size_t 要素数
+         */
+        std::size_t getBlockSize(const std::size_t blockIndex) const
+        {
+            assert(blockIndex < getBlockNum());
+            return std::min(getBlockEntityNum(), mSize - blockIndex * getBlockEntityNum());
+        }
+
+        /**
+         * @brief 先頭イテレータを取得する(全要素が連続している場合のみ)
+         *
+         * @return iterator
          */
         iterator begin() noexcept
         {
-            assert(mAddress);
+            assert(isContiguous() || !"the array is not contiguous! use getBlock");
             return mAddress;
         }
 
         /**
          * @brief 終端イテレータを取得する
-         * 
-         * @return iterator 
+         *
+         * @return iterator
          */
         iterator end() noexcept
         {
-            assert(mAddress);
+            assert(isContiguous() || !"the array is not contiguous! use getBlock");
             return mAddress + mSize;
         }
 
         /**
          * @brief const先頭イテレータを取得する
-         * 
-         * @return const_iterator 
+         *
+         * @return const_iterator
          */
         const_iterator cbegin() const noexcept
         {
-            assert(mAddress);
+            assert(isContiguous() || !"the array is not contiguous! use getBlock");
             return mAddress;
         }
 
         /**
          * @brief const終端イテレータを取得する
-         * 
-         * @return const_iterator 
+         *
+         * @return const_iterator
          */
         const_iterator cend() const noexcept
         {
-            assert(mAddress);
+            assert(isContiguous() || !"the array is not contiguous! use getBlock");
             return mAddress + mSize;
         }
 
         /**
          * @brief 逆先頭イテレータを取得する
-         * 
-         * @return reverse_iterator 
+         *
+         * @return reverse_iterator
          */
         reverse_iterator rbegin() noexcept
         {
-            assert(mAddress);
+            assert(isContiguous() || !"the array is not contiguous! use getBlock");
             return reverse_iterator{mAddress + mSize};
         }
 
         /**
          * @brief 逆終端イテレータを取得する
-         * 
-         * @return reverse_iterator 
+         *
+         * @return reverse_iterator
          */
         reverse_iterator rend() noexcept
         {
-            assert(mAddress);
+            assert(isContiguous() || !"the array is not contiguous! use getBlock");
             return reverse_iterator{mAddress};
         }
 
     private:
+        /**
+         * @brief 添字の要素のアドレスを求める
+         *
+         * @param index 添字
+         * @return T* アドレス
+         */
+        T* getPointer(const std::size_t index) const
+        {
+            if (isContiguous())
+            {
+                return mAddress + index;
+            }
+
+            // Tがconstの場合(読み出し専用の配列)はconstを保ったままバイト単位で辿る
+            using Byte = std::conditional_t<std::is_const_v<T>, const std::byte, std::byte>;
+
+            Byte* const pBlock = reinterpret_cast<Byte*>(mAddress) + (index >> mBlockShift) * mBlockStride;
+            return reinterpret_cast<T*>(pBlock) + (index & (mBlockEntityNum - 1));
+        }
+
         //! 開始アドレス
         T* mAddress;
         //! 要素数
         std::size_t mSize;
+        //! 1ブロックあたりの要素数(全要素が連続している場合は0)
+        std::size_t mBlockEntityNum;
+        //! 添字からブロックの添字を求めるシフト量
+        std::size_t mBlockShift;
+        //! ブロックの間隔(バイト)
+        std::size_t mBlockStride;
     };
 }  // namespace mvecs
 
-#endif
\ No newline at end of file
+#endif
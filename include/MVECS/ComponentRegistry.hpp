@@ -0,0 +1,76 @@
+#ifndef MVECS_MVECS_COMPONENTREGISTRY_HPP_
+#define MVECS_MVECS_COMPONENTREGISTRY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "ComponentSignature.hpp"
+#include "TypeInfo.hpp"
+
+namespace mvecs
+{
+    /**
+     * @brief ComponentData型に0から連番のIDを割り当て、IDをキーに型情報(TypeInfo)を登録する
+     * @details IDは型が初めて登録された時に割り当てられ、プロセス内で共通(全てのWorldで同じ)
+     *          ComponentSignatureのビットの位置に使う スレッドセーフ
+     *          登録した型情報(サイズ・アラインメント・trivialかどうか・範囲毎の構築・破棄・移動の関数)はIDから引ける
+     * @warning 登録できる型はプロセス全体でMaxComponentTypeNum(ComponentSignature::BitNum = 256)種類まで
+     *          超えた場合はリリースビルドでもメッセージを出してstd::abortする(BitNumを増やせば上限を上げられる)
+     */
+    class ComponentRegistry
+    {
+    public:
+        //! 割り当てられるIDの個数
+        static constexpr std::size_t MaxComponentTypeNum = ComponentSignature::BitNum;
+        //! 登録されていない型を表すID
+        static constexpr std::uint32_t InvalidID = std::numeric_limits<std::uint32_t>::max();
+
+        /**
+         * @brief 型情報を登録してIDを取得する(登録済みの場合は既存のIDを返す)
+         * @details 新しい型でMaxComponentTypeNumを超える場合はstd::abortする
+         *
+         * @param type ComponentData型の型情報
+         * @return std::uint32_t ID
+         */
+        static std::uint32_t registerType(const TypeInfo& type);
+
+        /**
+         * @brief 型のハッシュ値に対応するIDを取得する
+         *
+         * @param typeHash ComponentData型のハッシュ値
+         * @return std::uint32_t ID(登録されていない場合はInvalidID)
+         */
+        static std::uint32_t getID(const std::uint32_t typeHash);
+
+        /**
+         * @brief ComponentData型のIDを取得する(型毎に1回だけ登録・検索する)
+         *
+         * @tparam T ComponentData型
+         * @return std::uint32_t ID
+         */
+        template <typename T>
+        static std::uint32_t getID()
+        {
+            static const std::uint32_t id = registerType(TypeInfo::create<T>());
+            return id;
+        }
+
+        /**
+         * @brief IDに対応する型情報を取得する
+         *
+         * @param id registerTypeで割り当てられたID
+         * @return const TypeInfo& 型情報
+         */
+        static const TypeInfo& getTypeInfo(const std::uint32_t id);
+
+        /**
+         * @brief 割り当て済みのIDの個数を取得する
+         *
+         * @return std::size_t 個数
+         */
+        static std::size_t getRegisteredNum();
+    };
+}  // namespace mvecs
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef MVECS_MVECS_COMPONENTSIGNATURE_HPP_
+#define MVECS_MVECS_COMPONENTSIGNATURE_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace mvecs
+{
+    /**
+     * @brief ComponentData型のID(ComponentRegistryで割り当てる)の集合を表す固定長のビット集合
+     * @details 部分集合・一致・共通部分の判定はワード毎のAND/比較数回で済む
+     *          IDはComponentRegistryがBitNum未満であることを保証する(超える型の登録はそこで止まる)
+     */
+    class ComponentSignature
+    {
+    public:
+        //! 表せるIDの個数
+        static constexpr std::size_t BitNum = 256;
+
+        /**
+         * @brief コンストラクタ(空集合)
+         *
+         */
+        constexpr ComponentSignature()
+            : mWords()
+        {
+        }
+
+        /**
+         * @brief IDを追加する
+         *
+         * @param id ComponentData型のID
+         */
+        constexpr void set(const std::uint32_t id)
+        {
+            assert(id < BitNum || !"over max ComponentData type num!");
+            mWords[id / WordBitNum] |= std::uint64_t(1) << (id % WordBitNum);
+        }
+
+        /**
+         * @brief IDを削除する
+         *
+         * @param id ComponentData型のID
+         */
+        constexpr void reset(const std::uint32_t id)
+        {
+            assert(id < BitNum || !"over max ComponentData type num!");
+            mWords[id / WordBitNum] &= ~(std::uint64_t(1) << (id % WordBitNum));
+        }
+
+        /**
+         * @brief IDを含むかどうか
+         *
+         * @param id ComponentData型のID
+         * @return true 含む
+         * @return false 含まない
+         */
+        constexpr bool test(const std::uint32_t id) const
+        {
+            assert(id < BitNum || !"over max ComponentData type num!");
+            return (mWords[id / WordBitNum] >> (id % WordBitNum)) & 1;
+        }
+
+        /**
+         * @brief otherがthisの部分集合かどうか
+         *
+         * @param other 判定対象
+         * @return true 部分集合
+         * @return false 部分集合でない
+         */
+        constexpr bool contains(const ComponentSignature& other) const
+        {
+            for (std::size_t i = 0; i < WordNum; ++i)
+            {
+                if ((mWords[i] & other.mWords[i]) != other.mWords[i])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief otherと共通するIDがあるかどうか
+         *
+         * @param other 判定対象
+         * @return true 共通するIDがある
+         * @return false 互いに素
+         */
+        constexpr bool intersects(const ComponentSignature& other) const
+        {
+            for (std::size_t i = 0; i < WordNum; ++i)
+            {
+                if (mWords[i] & other.mWords[i])
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief 空集合かどうか
+         *
+         * @return true 空
+         * @return false 空でない
+         */
+        constexpr bool empty() const
+        {
+            for (std::size_t i = 0; i < WordNum; ++i)
+            {
+                if (mWords[i])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief 等しい
+         *
+         * @param other
+         * @return true
+         * @return false
+         */
+        constexpr bool operator==(const ComponentSignature& other) const
+        {
+            for (std::size_t i = 0; i < WordNum; ++i)
+            {
+                if (mWords[i] != other.mWords[i])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief 等しくない
+         *
+         * @param other
+         * @return true
+         * @return false
+         */
+        constexpr bool operator!=(const ComponentSignature& other) const
+        {
+            return !(*this == other);
+        }
+
+        /**
+         * @brief ハッシュ値を取得する(ハッシュテーブルのキーに使う)
+         *
+         * @return constexpr std::size_t ハッシュ値
+         */
+        constexpr std::size_t getHash() const
+        {
+            std::uint64_t rtn = 14695981039346656037ull;
+            for (std::size_t i = 0; i < WordNum; ++i)
+            {
+                rtn = (rtn ^ mWords[i]) * 1099511628211ull;
+                rtn ^= rtn >> 32;
+            }
+
+            return static_cast<std::size_t>(rtn);
+        }
+
+    private:
+        //! 1ワードのビット数
+        static constexpr std::size_t WordBitNum = 64;
+        //! ワード数
+        static constexpr std::size_t WordNum = BitNum / WordBitNum;
+
+        //! ビット列
+        std::uint64_t mWords[WordNum];
+    };
+}  // namespace mvecs
+
+/**
+ * @brief ComponentSignatureをstd::unordered_mapのキーにするための特殊化
+ *
+ */
+template <>
+struct std::hash<mvecs::ComponentSignature>
+{
+    std::size_t operator()(const mvecs::ComponentSignature& signature) const noexcept
+    {
+        return signature.getHash();
+    }
+};
+
+#endif
@@ -3,44 +3,108 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <limits>
+#include <type_traits>
 
 namespace mvecs
 {
     /**
      * @brief 実体を表す 振る舞いとしては旧来のGameObject
+     * @details 実体はWorldのEntityTableのスロット添字と世代番号の組(64bit)で、コピーは自由に行える
      *
      */
     struct Entity
     {
+        //! どのスロットも指さないことを表す添字
+        static constexpr std::uint32_t InvalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+        /**
+         * @brief デフォルトコンストラクタ(無効なEntityになる)
+         *
+         */
+        constexpr Entity()
+            : mIndex(InvalidIndex)
+            , mGeneration(0)
+        {
+        }
+
         /**
          * @brief コンストラクタ
          *
-         * @param ID ChunkでのID
-         * @param chunkID ChunkのID
+         * @param index EntityTableでのスロット添字
+         * @param generation スロットの世代番号
+         */
+        constexpr Entity(std::uint32_t index, std::uint32_t generation)
+            : mIndex(index)
+            , mGeneration(generation)
+        {
+        }
+
+        /**
+         * @brief 等しい
+         *
+         * @param other
+         * @return true
+         * @return false
          */
-        Entity(std::size_t* pID, std::size_t chunkID);
+        constexpr bool operator==(const Entity& other) const
+        {
+            return mIndex == other.mIndex && mGeneration == other.mGeneration;
+        }
 
         /**
-         * @brief ChunkでのIDを取得
+         * @brief 等しくない
          *
-         * @return std::size_t ID ChunkでのID
+         * @param other
+         * @return true
+         * @return false
          */
-        std::size_t getID() const;
+        constexpr bool operator!=(const Entity& other) const
+        {
+            return !(*this == other);
+        }
 
         /**
-         * @brief ChunkのIDを取得
+         * @brief EntityTableでのスロット添字を取得
          *
-         * @return std::size_t ChunkのID
+         * @return std::uint32_t スロット添字
          */
-        std::size_t getChunkID() const;
+        constexpr std::uint32_t getIndex() const
+        {
+            return mIndex;
+        }
+
+        /**
+         * @brief スロットの世代番号を取得
+         *
+         * @return std::uint32_t 世代番号
+         */
+        constexpr std::uint32_t getGeneration() const
+        {
+            return mGeneration;
+        }
+
+        /**
+         * @brief 有効なスロットを指しうるかどうか(破棄済みかどうかはWorld::isAliveで判定する)
+         *
+         * @return true 有効
+         * @return false 無効
+         */
+        constexpr bool isValid() const
+        {
+            return mIndex != InvalidIndex;
+        }
 
     private:
-        //! ChunkでのIDへのアドレス
-        std::size_t* mpID;
-        //! ChunkのID
-        std::size_t mChunkID;
+        //! EntityTableでのスロット添字
+        std::uint32_t mIndex;
+        //! スロットの世代番号(破棄の度に進む)
+        std::uint32_t mGeneration;
     };
 
+    static_assert(sizeof(Entity) == sizeof(std::uint64_t), "Entity must be a 64bit handle");
+    static_assert(std::is_trivially_copyable_v<Entity>, "Entity must be trivially copyable");
+
 }  // namespace mvecs
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,136 @@
+#ifndef MVECS_MVECS_ENTITYTABLE_HPP_
+#define MVECS_MVECS_ENTITYTABLE_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "Entity.hpp"
+
+namespace mvecs
+{
+    class IChunk;
+
+    /**
+     * @brief Entityの実体の位置(Chunkと行)を保持するスロット
+     *
+     */
+    struct EntitySlot
+    {
+        //! 所属するChunk(未使用スロットではnullptr)
+        IChunk* pChunk;
+        //! Chunk内での行(未使用スロットでは次の空きスロットの添字)
+        std::uint32_t row;
+        //! 世代番号(スロットが解放される度に進む)
+        std::uint32_t generation;
+    };
+
+    /**
+     * @brief World毎のEntityスロットテーブル
+     * @details 解放したスロットは空きリストで再利用するため、Entityの生成・破棄はテーブルが伸び切った後はメモリ確保を伴わない
+     *
+     */
+    class EntityTable
+    {
+    public:
+        /**
+         * @brief コンストラクタ
+         *
+         * @param pMemoryResource スロットのメモリを確保するリソース
+         */
+        explicit EntityTable(std::pmr::memory_resource* pMemoryResource = std::pmr::get_default_resource());
+
+        /**
+         * @brief スロットを割り当ててEntityを生成する
+         *
+         * @param pChunk 所属するChunk
+         * @param row Chunk内での行
+         * @return Entity 生成したEntity
+         */
+        Entity create(IChunk* pChunk, std::size_t row);
+
+        /**
+         * @brief Entityのスロットを解放する(世代が進むので古いEntityは無効になる)
+         *
+         * @param entity 解放するEntity
+         */
+        void release(const Entity& entity);
+
+        /**
+         * @brief 指定した個数までスロットを事前に確保する
+         *
+         * @param slotNum スロット数
+         */
+        void reserve(std::size_t slotNum);
+
+        /**
+         * @brief Entityがまだ生存しているかどうか(O(1))
+         *
+         * @param entity 判定するEntity
+         * @return true 生存している
+         * @return false 破棄済み、もしくは無効
+         */
+        bool isAlive(const Entity& entity) const
+        {
+            return entity.getIndex() < mSlots.size() && mSlots[entity.getIndex()].generation == entity.getGeneration() && mSlots[entity.getIndex()].pChunk;
+        }
+
+        /**
+         * @brief Entityが所属するChunkを取得する
+         *
+         * @param entity 生存しているEntity
+         * @return IChunk* 所属するChunk
+         */
+        IChunk* getChunk(const Entity& entity) const
+        {
+            assert(isAlive(entity) || !"this entity was already destroyed!");
+            return mSlots[entity.getIndex()].pChunk;
+        }
+
+        /**
+         * @brief EntityのChunk内での行を取得する
+         *
+         * @param entity 生存しているEntity
+         * @return std::size_t 行
+         */
+        std::size_t getRow(const Entity& entity) const
+        {
+            assert(isAlive(entity) || !"this entity was already destroyed!");
+            return mSlots[entity.getIndex()].row;
+        }
+
+        /**
+         * @brief Entityの位置を更新する(Chunk内で行が移動した時に呼ぶ)
+         *
+         * @param entity 生存しているEntity
+         * @param pChunk 新しい所属Chunk
+         * @param row 新しい行
+         */
+        void setLocation(const Entity& entity, IChunk* pChunk, std::size_t row)
+        {
+            assert(isAlive(entity) || !"this entity was already destroyed!");
+            EntitySlot& slot = mSlots[entity.getIndex()];
+            slot.pChunk      = pChunk;
+            slot.row         = static_cast<std::uint32_t>(row);
+        }
+
+        /**
+         * @brief 生存しているEntityの個数を取得する
+         *
+         * @return std::size_t 個数
+         */
+        std::size_t getAliveNum() const;
+
+    private:
+        //! スロットたち
+        std::pmr::vector<EntitySlot> mSlots;
+        //! 空きリストの先頭スロット添字
+        std::uint32_t mFreeHead;
+        //! 生存しているEntityの個数
+        std::size_t mAliveNum;
+    };
+}  // namespace mvecs
+
+#endif
@@ -2,16 +2,22 @@
 #ifndef MVECS_MVECS_ICHUNK_HPP_
 #define MVECS_MVECS_ICHUNK_HPP_
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <type_traits>
 #include <vector>
 
 #include "Archetype.hpp"
 #include "ComponentArray.hpp"
 #include "Entity.hpp"
+#include "EntityTable.hpp"
+#include "MemoryResource.hpp"
 
 /**
  * @brief mvecs
@@ -20,35 +26,131 @@
 namespace mvecs
 {
     /**
-     * @brief ChunkNX̃C^tF[X ComponentData
+     * @brief Entity削除時の行の詰め方
+     *
+     */
+    enum class RemovalMode
+    {
+        //! 末尾の行を空いた行に移動する(O(1)、行の順序は保たれない)
+        SwapAndPop,
+        //! 後ろの行を全て前にずらす(O(n)、行の順序を保つ)
+        KeepOrder,
+    };
+
+    /**
+     * @brief ChunkのEntityの保持の仕方
+     *
+     */
+    enum class StorageMode
+    {
+        //! 1つのメモリ領域に全Entityを保持し、足りなくなったら割り当て直す
+        Contiguous,
+        //! 固定サイズのページ(Chunk)に分けて保持し、足りなくなったら新しいページを追加する(既存の行は移動しない)
+        Paged,
+    };
+
+    /**
+     * @brief Chunk内のComponentDataの列の並べ方
+     *
+     */
+    enum class ColumnLayout
+    {
+        //! 型毎に全Entity分の列を並べる(Structure of Arrays)
+        SoA,
+        //! 各型の固定数のEntity分の列を順に並べたブロックを繰り返す(Array of Structures of Arrays)
+        //! 同時に読む小さいComponentDataが近くに置かれ、ブロック内は連続しているためSIMDでも読める
+        AoSoA,
+    };
+
+    /**
+     * @brief 連続領域のChunkの容量の伸ばし方・切り詰め方
+     * @details Entity数が容量に達したら伸ばし、容量のshrinkThreshold倍を下回ったらgrowthFactorで割って切り詰める
+     *          shrinkThreshold * growthFactor < 1 であれば、切り詰めた直後に伸ばし直すことはない(ヒステリシス)
+     *          この差を大きくするほど増減を繰り返す場合の割り当て直しが減る
+     *          範囲外の値はIChunk::setCapacityPolicyで範囲内に丸められる(リリースビルドでも)
+     */
+    struct CapacityPolicy
+    {
+        //! growthFactorの下限(これ未満はこの値に丸める 1以下では切り詰めが進まないため)
+        static constexpr float MinGrowthFactor = 1.125f;
+
+        //! 伸ばす時に現在の容量に掛ける係数(MinGrowthFactor以上)
+        float growthFactor = 2.f;
+        //! Entity数が容量のこの割合を下回ったら切り詰める([0, 1)、範囲外は切り詰めない)
+        float shrinkThreshold = 1.f / 3.f;
+        //! これより小さい容量には切り詰めない
+        std::size_t minEntityNum = 16;
+        //! 切り詰めを行わない(shrinkToFitでのみ切り詰める)
+        bool neverShrink = false;
+    };
+
+    /**
+     * @brief Chunkの割り当て直しの統計
+     *
+     */
+    struct ReallocationStats
+    {
+        //! 伸ばした回数
+        std::size_t growCount = 0;
+        //! 切り詰めた回数
+        std::size_t shrinkCount = 0;
+        //! 割り当て直しでコピー(移動)したバイト数
+        std::size_t copiedBytes = 0;
+
+        /**
+         * @brief 統計を足し合わせる
+         *
+         * @param other
+         * @return ReallocationStats&
+         */
+        ReallocationStats& operator+=(const ReallocationStats& other)
+        {
+            growCount += other.growCount;
+            shrinkCount += other.shrinkCount;
+            copiedBytes += other.copiedBytes;
+            return *this;
+        }
+    };
+
+    /**
+     * @brief Chunkクラスのインタフェース ComponentDataの
      *
      */
     class IChunk
     {
+        //! moveToで移動先のChunkの行を確保するため
+        template <typename... Args>
+        friend class Chunk;
+
     public:
+        //! AoSoAの場合のデフォルトの1ブロックあたりのEntity数
+        static constexpr std::size_t DefaultBlockEntityNum = 16;
 
         /**
-         * @brief RXgN^
+         * @brief コンストラクタ
          *
          * @param ID
+         * @param archetype
+         * @param pEntityTable Entityの位置を登録するテーブル(Worldが持つもの)
+         * @param pMemoryResource ComponentDataと行の管理情報のメモリを確保するリソース
          */
-        IChunk(const std::size_t ID, const Archetype& archetype);
+        IChunk(const std::size_t ID, const Archetype& archetype, EntityTable* pEntityTable, std::pmr::memory_resource* pMemoryResource);
 
         /**
-         * @brief fXgN^
+         * @brief デストラクタ
          *
          */
         virtual ~IChunk();
 
         /**
-         * @brief Rs[RXgN^delete
+         * @brief コピーコンストラクタはdelete
          *
          * @param src
          */
         IChunk(IChunk& src) = delete;
 
         /**
-         * @brief ɂRs[delete
+         * @brief 代入によるコピーもdelete
          *
          * @param src
          * @return IChunk&
@@ -56,14 +158,14 @@ namespace mvecs
         IChunk& operator=(const IChunk& src) = delete;
 
         /**
-         * @brief [uRXgN^
+         * @brief ムーブコンストラクタ
          *
-         * @param src [u
+         * @param src ムーブ元
          */
         IChunk(IChunk&& src) noexcept;
 
         /**
-         * @brief [uRXgN^ ZqI[o[[h
+         * @brief ムーブコンストラクタ 演算子オーバーロード
          *
          * @param src
          * @return IChunk&
@@ -71,58 +173,87 @@ namespace mvecs
         IChunk& operator=(IChunk&& src) noexcept;
 
         /**
-         * @brief ChunkID擾
+         * @brief ChunkのIDを取得する
          *
          * @return std::size_t ID
          */
         std::size_t getID() const;
 
         /**
-         * @brief Archetype擾
+         * @brief Archetypeを取得する
          *
          * @return Archetype
          */
         const Archetype& getArchetype() const;
 
         /**
-         * @brief Entitÿ̗mۂ
-         * @details ۂ̒l͉܂ĂȂ̂Œ
+         * @brief Entityの領域を確保する
+         * @details 実際の値は何も書き込まれていないので注意
          * @return Entity
          */
         virtual Entity allocate() = 0;
 
         /**
-         * @brief w肵Entity폜ăl߂
-         *
-         * @param entity 폜Entity
+         * @brief 複数のEntityの領域をまとめて確保する
+         * @details 容量の確保は1回のみで、各ComponentDataは型毎に列単位でまとめて構築される
+         * @param count 確保するEntity数
+         * @param entities 確保したEntityを末尾に追加する先(行の順に並ぶ)
+         */
+        virtual void allocate(const std::size_t count, std::vector<Entity>& entities) = 0;
+
+        /**
+         * @brief 指定したEntityを削除してメモリを詰める
+         * @details 移動した行のEntityはEntityTable上の位置も更新される
+         * @param entity 削除するEntity
+         * @param mode 行の詰め方
+         */
+        virtual void deallocate(const Entity& entity, RemovalMode mode = RemovalMode::SwapAndPop) = 0;
+
+        /**
+         * @brief 指定した複数の行のEntityをまとめて削除し、1回の走査でメモリを詰める
+         * @details メモリの切り詰めの判定も1回だけ行われる
+         * @param rows 削除する行(昇順・重複なし)
+         * @param mode 行の詰め方
          */
-        virtual void deallocate(const Entity& entity) = 0;
+        virtual void deallocate(const std::vector<std::size_t>& rows, RemovalMode mode = RemovalMode::SwapAndPop) = 0;
 
         /**
-         * @brief ŜNAAsize=1ɂ
+         * @brief メモリ全体をクリアし、size=1にする
          *
          */
         void clear();
 
         /**
-         * @brief SChunkj(Sĉ)
+         * @brief 完全にChunkを破棄する(メモリを全て解放する)
          *
          */
         virtual void destroy() = 0;
 
         /**
-         * @brief entityotherChunkɈړ
-         *
-         * @param other ړChunk
+         * @brief entityの行をotherのChunkに移動する(ComponentDataの追加・削除に使う)
+         * @details 共通する型は列毎に移動先にムーブし、otherに無い型は破棄する otherにしか無い型はデフォルト構築される
+         *          Entityはそのままで、EntityTable上の位置のみ更新される
+         * @param entity 移動するEntity
+         * @param other 移動先Chunk(ページの場合は満杯でないこと)
+         * @param mode 移動元の行の詰め方
+         */
+        virtual void moveTo(const Entity& entity, IChunk& other, RemovalMode mode = RemovalMode::SwapAndPop) = 0;
+
+        /**
+         * @brief ComponentData型を追加・削除した時の移動先Chunkのキャッシュを取得する
+         * @details 無ければnullptrで追加される(Worldが移動先を探して書き込む)
+         * @param typeHash 追加・削除するComponentData型のハッシュ
+         * @param added 追加ならtrue、削除ならfalse
+         * @return IChunk*& 移動先Chunk
          */
-        //Entity moveTo(const Entity& entity, Chunk& other);
+        IChunk*& getTransition(const std::uint32_t typeHash, const bool added);
 
         /**
-         * @brief ComponentData̒l
+         * @brief ComponentDataの値を書き込む
          *
-         * @tparam T ComponentDatǎ^
-         * @param entity ݐEntity
-         * @param value ComponentData
+         * @tparam T ComponentDataの型
+         * @param entity 書き込み先Entity
+         * @param value 書き込むComponentData
          */
         //template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
         //void setComponentData(const Entity& entity, const T& value)
@@ -130,95 +261,478 @@ namespace mvecs
         //    assert(mArchetype.isIn<T>() || !"T is not in Archetype");
         //    assert(entity.getID() <= mEntityNum || !"invalid entity ID!");
 
-        //    // ތ^܂ł̃ItZbg
+        //    // 書き込む型までのオフセット
         //    const std::size_t offset = mArchetype.getTypeOffset(mArchetype.getTypeIndex<T>(), mMaxEntityNum);
 
-        //    // 
+        //    // 書き込み
         //    std::memcpy(mpMemory + offset + entity.getID() * sizeof(T), &value, sizeof(T));
         //}
 
         /**
-         * @brief  ComponentData̒l擾
-         *
-         * @tparam T 擾ComponentDatǎ^
-         * @tparam typename ComponentData^肷
-         * @param entity 擾Entity
-         * @return 擾l
+         * @brief  ComponentDataの値を取得する
+         * @details Tがconstでなければ書き込まれるものとして列の変更バージョンを更新する(読むだけならconst Tを指定する)
+         * @tparam T 取得するComponentDataの型(const可)
+         * @tparam typename ComponentData型か判定する
+         * @param row 取得先の行(EntityTable::getRowで取得できるもの)
+         * @return 取得した値
          */
         template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
-        T& getComponentData(const Entity& entity) const
+        T& getComponentData(const std::size_t row) const
         {
-            assert(mArchetype.isIn<T>() || !"T is not in Archetype");
-
-            // ތ^܂ł̃ItZbg
-            std::size_t offset = mArchetype.getTypeOffset(mArchetype.getTypeIndex<T>(), mMaxEntityNum);
-
-            // ǂݏo
-            return *(reinterpret_cast<T*>(mpMemory + offset + entity.getID() * sizeof(T)));
+            using U = std::remove_const_t<T>;
+            assert(mArchetype.isIn<U>() || !"T is not in Archetype");
+            assert(row < mEntityNum || !"invalid row!");
+
+            const std::size_t column = getColumnIndex<U>();
+            if constexpr (!std::is_const_v<T>)
+            {
+                markChanged(column);
+            }
+
+            // 読み出し(列の先頭アドレス + 行 * 型サイズ)
+            return *(reinterpret_cast<T*>(getAddress(column, row)));
         }
 
         /**
-         * @brief Entity烁蓖Ē
+         * @brief Entityが増えたらメモリを割り当て直す
          *
-         * @param maxEntityNum VőEntity
+         * @param maxEntityNum 新しい最大Entity数
          */
         virtual void reallocate(const std::size_t maxEntityNum) = 0;
 
         /**
-         * @brief w肵^ComponentArray擾
-         * @details nꂽAhX͖ɂȂ\邽ߑɂ͒ӂ
-         * @tparam T ComponentDatǎ^
-         * @tparam typename ComponentData^p
+         * @brief 少なくともentityNum個のEntityを割り当て直さずに保持できるようにする
+         * @details 確保した容量はshrinkToFitを呼ぶまで自動では切り詰められない(連続領域の場合のみ)
+         * @param entityNum Entity数
+         */
+        void reserve(const std::size_t entityNum);
+
+        /**
+         * @brief 容量を現在のEntity数まで切り詰める(reserveした容量も解放する)
+         * @details ページの場合は空のページのメモリのみ解放する
+         */
+        void shrinkToFit();
+
+        /**
+         * @brief 容量の伸ばし方・切り詰め方を設定する
+         * @details growthFactorがMinGrowthFactor未満ならMinGrowthFactorに、shrinkThresholdが[0, 1)の外なら0(切り詰めない)に丸める
+         * @param policy
+         */
+        void setCapacityPolicy(const CapacityPolicy& policy);
+
+        /**
+         * @brief 容量の伸ばし方・切り詰め方を取得する
+         *
+         * @return const CapacityPolicy&
+         */
+        const CapacityPolicy& getCapacityPolicy() const;
+
+        /**
+         * @brief 割り当て直しの統計を取得する
+         *
+         * @return const ReallocationStats&
+         */
+        const ReallocationStats& getReallocationStats() const;
+
+        /**
+         * @brief 指定した型のComponentArrayを取得する
+         * @details 渡されたアドレスは無効になる可能性があるため操作には注意する
+         *          AoSoAの場合はブロック毎に連続した配列になる(ComponentArray::getBlockで取得できる)
+         *          Tがconstでなければ書き込まれるものとして列の変更バージョンを更新する(読むだけならconst Tを指定する)
+         * @tparam T ComponentDataの型(const可)
+         * @tparam typename ComponentData型判定用
          * @return ComponentArray<T>
          */
         template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
         ComponentArray<T> getComponentArray() const
         {
-            assert(mArchetype.isIn<T>() || !"T is not in Archetype");
+            using U = std::remove_const_t<T>;
+            assert(mArchetype.isIn<U>() || !"T is not in Archetype");
+
+            const std::size_t column = getColumnIndex<U>();
+            if constexpr (!std::is_const_v<T>)
+            {
+                markChanged(column);
+            }
+
+            T* const pFirst = reinterpret_cast<T*>(getAddress(column, 0));
+
+            if (mColumnLayout == ColumnLayout::AoSoA)
+            {
+                return ComponentArray<T>(pFirst, mEntityNum, mBlockEntityNum, mBlockStride);
+            }
+
+            return ComponentArray<T>(pFirst, mEntityNum);
+        }
 
-            // gp^܂ł̃ItZbg
-            std::size_t offset = mArchetype.getTypeOffset(mArchetype.getTypeIndex<T>(), mMaxEntityNum);
+        /**
+         * @brief ComponentData型の列が最後に書き込み可能な形で渡された(もしくは行が増減した)時のバージョンを取得する
+         *
+         * @tparam T ComponentData型
+         * @return std::uint64_t 変更バージョン(Worldの変更バージョン)
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        std::uint64_t getChangeVersion() const
+        {
+            return mColumns[getColumnIndex<std::remove_const_t<T>>()].changeVersion.load(std::memory_order_relaxed);
+        }
 
-            return ComponentArray<T>(reinterpret_cast<T*>(mpMemory + offset), mEntityNum);
+        /**
+         * @brief ComponentData型の列がversionより後に変更されたかどうか
+         *
+         * @tparam T ComponentData型
+         * @param version 比較するバージョン(System毎の前回の実行時のバージョンなど)
+         * @return true 変更された
+         * @return false 変更されていない
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        bool isChangedSince(const std::uint64_t version) const
+        {
+            return getChangeVersion<T>() > version;
         }
 
         /**
-         * @brief ݂Entity̌擾
+         * @brief 変更バージョンの参照先を設定する(Worldが持つもの、構築直後に呼ぶ)
+         * @details 列の変更バージョンには書き込み可能な形で渡した時点の*pChangeVersionが記録される
+         * @param pChangeVersion Worldの変更バージョン(nullptrなら常に0を記録する)
+         */
+        void setChangeVersionSource(const std::uint64_t* pChangeVersion);
+
+        /**
+         * @brief 現在のEntityの個数を取得する
          *
-         * @return std::size_t 
+         * @return std::size_t 個数
          */
         std::size_t getEntityNum() const;
 
         /**
-         * @brief _v
+         * @brief 現在確保されている最大Entity数を取得する
+         *
+         * @return std::size_t 最大Entity数
+         */
+        std::size_t getMaxEntityNum() const;
+
+        /**
+         * @brief 保持の仕方を取得する
+         *
+         * @return StorageMode
+         */
+        StorageMode getStorageMode() const;
+
+        /**
+         * @brief 列の並べ方を取得する
+         *
+         * @return ColumnLayout
+         */
+        ColumnLayout getColumnLayout() const;
+
+        /**
+         * @brief AoSoAの場合の1ブロックあたりのEntity数を取得する
+         *
+         * @return std::size_t Entity数(SoAの場合は0)
+         */
+        std::size_t getBlockEntityNum() const;
+
+        /**
+         * @brief これ以上Entityを確保できないかどうか(ページの場合のみ満杯になる)
+         *
+         * @return true 満杯
+         * @return false まだ確保できる
+         */
+        bool isFull() const;
+
+        /**
+         * @brief 割り当て直さずに(ページの場合は満杯になるまでに)確保できるEntity数を取得する
+         * @details 連続領域の場合は割り当て直しで伸びるため上限なし
+         * @return std::size_t 確保できるEntity数
+         */
+        std::size_t getAllocatableEntityNum() const;
+
+        /**
+         * @brief 指定した行のEntityを取得する
+         *
+         * @param row 行
+         * @return Entity
+         */
+        Entity getEntity(const std::size_t row) const;
+
+        /**
+         * @brief 全行のEntityを取得する(行の順に並ぶ、要素数はgetEntityNum())
+         * @details 渡されたアドレスはEntityの確保・削除で無効になる可能性があるため操作には注意する
+         * @return const Entity* 先頭アドレス
+         */
+        const Entity* getEntities() const;
+
+        /**
+         * @brief メモリを確保するリソースを取得する
+         *
+         * @return std::pmr::memory_resource*
+         */
+        std::pmr::memory_resource* getMemoryResource() const;
+
+        /**
+         * @brief メモリダンプ
          *
          */
         void dumpMemory() const;
 
         /**
-         * @brief EntityIDƎۂ̃ΉÂĂ镔_v
+         * @brief 各行とEntityの対応をダンプする
          *
          */
         void dumpIndexMemory() const;
 
     protected:
 
-        //void insertEntityIndex(std::size_t* pIndex);
+        /**
+         * @brief 他のChunkから移動してくるEntityの行を確保する(moveToから呼ばれる)
+         * @details srcArchetypeに無い型のみデフォルト構築され、共通する型は移動元がムーブ構築する
+         * @param entity 移動してくるEntity(EntityTable上の位置はこのChunkに更新される)
+         * @param srcArchetype 移動元のArchetype
+         * @return std::size_t 確保した行
+         */
+        virtual std::size_t allocateForMove(const Entity& entity, const Archetype& srcArchetype) = 0;
+
+        /**
+         * @brief 列の並べ方を設定する(メモリを確保する前に呼ぶ)
+         *
+         * @param columnLayout 列の並べ方
+         * @param blockEntityNum AoSoAの場合の1ブロックあたりのEntity数(2の冪)
+         */
+        void setColumnLayout(const ColumnLayout columnLayout, const std::size_t blockEntityNum);
+
+        /**
+         * @brief ComponentData型の列の添字(Archetype上の添字)を取得する
+         * @details Chunk構築時に作ったID -> 列の表を引くだけで、Archetypeの型を走査しない
+         * @tparam T ComponentData型
+         * @return std::size_t 列の添字
+         */
+        template <typename T>
+        std::size_t getColumnIndex() const
+        {
+            const std::uint32_t id = ComponentRegistry::getID<T>();
+            assert((id < mColumnIndexTable.size() && mColumnIndexTable[id] != InvalidColumnIndex) || !"the type is not in this archetype!");
+
+            return mColumnIndexTable[id];
+        }
+
+        /**
+         * @brief [column]番目の列を現在の変更バージョンで変更されたことにする
+         *
+         * @param column Archetype上での型の添字
+         */
+        void markChanged(const std::size_t column) const
+        {
+            assert(column < mColumns.size());
+            mColumns[column].stamp(mpChangeVersion ? *mpChangeVersion : 0);
+        }
+
+        /**
+         * @brief 全ての列を現在の変更バージョンで変更されたことにする(行の確保・削除・移動時)
+         *
+         */
+        void markAllChanged() const;
 
-        //! ChunkID
+        /**
+         * @brief [column]番目(Archetype上の添字)の型の指定した行の要素のアドレスを取得する
+         * @details 割り当て直し毎に更新している列の先頭アドレスを使うので、オフセットの計算はしない
+         * @param column Archetype上での型の添字
+         * @param row 行
+         * @return std::byte* アドレス
+         */
+        std::byte* getAddress(const std::size_t column, const std::size_t row) const
+        {
+            assert(column < mColumns.size());
+            const Column& c = mColumns[column];
+
+            if (mColumnLayout == ColumnLayout::AoSoA)
+            {
+                return c.pBase + (row >> mBlockShift) * mBlockStride + (row & (mBlockEntityNum - 1)) * c.typeSize;
+            }
+
+            return c.pBase + row * c.typeSize;
+        }
+
+        /**
+         * @brief 指定したメモリ上での[column]番目の型の指定した行の要素のアドレスを取得する
+         *
+         * @param pMemory メモリ
+         * @param maxEntityNum pMemoryの最大Entity数
+         * @param column Archetype上での型の添字
+         * @param row 行
+         * @return std::byte* アドレス
+         */
+        std::byte* getAddress(std::byte* pMemory, const std::size_t maxEntityNum, const std::size_t column, const std::size_t row) const
+        {
+            if (mColumnLayout == ColumnLayout::AoSoA)
+            {
+                return pMemory + (row >> mBlockShift) * mBlockStride + mArchetype.getBlockTypeOffset(column, mBlockEntityNum) + (row & (mBlockEntityNum - 1)) * mArchetype.getTypeSize(column);
+            }
+
+            return pMemory + mArchetype.getTypeOffset(column, maxEntityNum) + row * mArchetype.getTypeSize(column);
+        }
+
+        /**
+         * @brief rowから何行がメモリ上で連続しているかを取得する
+         *
+         * @param row 先頭の行
+         * @param count 最大の行数
+         * @return std::size_t 連続している行数(count以下)
+         */
+        std::size_t getContiguousEntityNum(const std::size_t row, const std::size_t count) const
+        {
+            if (mColumnLayout == ColumnLayout::AoSoA)
+            {
+                return std::min(count, mBlockEntityNum - (row & (mBlockEntityNum - 1)));
+            }
+
+            return count;
+        }
+
+        /**
+         * @brief 列の並べ方に合わせて最大Entity数を切り上げる(AoSoAの場合はブロックの倍数)
+         *
+         * @param maxEntityNum 最大Entity数
+         * @return std::size_t 切り上げた最大Entity数
+         */
+        std::size_t getLayoutEntityNum(const std::size_t maxEntityNum) const;
+
+        /**
+         * @brief 指定した最大Entity数のメモリのサイズを取得する
+         *
+         * @param maxEntityNum 最大Entity数(getLayoutEntityNumで切り上げたもの)
+         * @return std::size_t サイズ(バイト)
+         */
+        std::size_t getLayoutMemorySize(const std::size_t maxEntityNum) const;
+
+        /**
+         * @brief 指定したEntity数分のComponentDataのメモリをリソースから確保する(0で埋められる)
+         *
+         * @param maxEntityNum Entity数
+         * @return std::byte* 確保したメモリ
+         */
+        std::byte* allocateMemory(const std::size_t maxEntityNum) const;
+
+        /**
+         * @brief allocateMemoryで確保したメモリをリソースに返す
+         *
+         * @param pMemory 返すメモリ
+         * @param maxEntityNum 確保した時のEntity数
+         */
+        void deallocateMemory(std::byte* pMemory, const std::size_t maxEntityNum) const;
+
+        /**
+         * @brief allocateMemoryで確保したメモリの大きさを変更する(リソースがResizableMemoryResourceの場合のみ)
+         * @details 先頭から変更前後の小さい方のサイズまでの内容は保たれる(列の位置は呼び出し側で直す)
+         * @param pMemory 変更するメモリ
+         * @param oldMaxEntityNum 現在のEntity数
+         * @param newMaxEntityNum 新しいEntity数
+         * @return std::byte* 新しいメモリ
+         */
+        std::byte* resizeMemory(std::byte* pMemory, const std::size_t oldMaxEntityNum, const std::size_t newMaxEntityNum) const;
+
+        /**
+         * @brief 各列の先頭アドレスを現在のメモリと最大Entity数に合わせて更新する
+         * @details mpMemory, mMaxEntityNumを変更したら必ず呼ぶ
+         */
+        void updateColumns();
+
+        /**
+         * @brief 列毎の情報(getAddressで使う)
+         *
+         */
+        struct Column
+        {
+            Column() = default;
+
+            Column(const Column& src)
+                : pBase(src.pBase)
+                , typeSize(src.typeSize)
+                , changeVersion(src.changeVersion.load(std::memory_order_relaxed))
+            {
+            }
+
+            Column& operator=(const Column& src)
+            {
+                pBase    = src.pBase;
+                typeSize = src.typeSize;
+                changeVersion.store(src.changeVersion.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                return *this;
+            }
+
+            /**
+             * @brief 変更バージョンを更新する(既に同じ値なら書き込まない)
+             * @details forEachParallelのジョブなど複数のスレッドから同時に呼ばれることがあるためatomicに読み書きする
+             *          書き込まれる値はどのスレッドでも実行中のWorldの変更バージョンなので、順序の保証は要らない
+             * @param version 変更バージョン
+             */
+            void stamp(const std::uint64_t version) const
+            {
+                if (changeVersion.load(std::memory_order_relaxed) != version)
+                {
+                    changeVersion.store(version, std::memory_order_relaxed);
+                }
+            }
+
+            //! 列の先頭アドレス(AoSoAの場合は先頭のブロック内での先頭アドレス)
+            std::byte* pBase = nullptr;
+            //! 型のサイズ
+            std::size_t typeSize = 0;
+            //! 最後に書き込み可能な形で渡された時の変更バージョン(読み出しのみのconstな操作からも更新する)
+            mutable std::atomic<std::uint64_t> changeVersion{0};
+        };
+
+        //! mColumnIndexTableで型を持たないことを表す値
+        static constexpr std::uint16_t InvalidColumnIndex = std::numeric_limits<std::uint16_t>::max();
+
+        //! ChunkのID
         std::size_t mID;
 
-        //! ƂƂȂArchetype
+        //! もととなるArchetype
         Archetype mArchetype;
-        //! AhX
+        //! メモリアドレス
         std::byte* mpMemory;
-        //! 蓖ĂőEntity
+        //! 各列の先頭アドレスと型のサイズ
+        std::vector<Column> mColumns;
+        //! ComponentData型のID(ComponentRegistry) -> 列の添字
+        std::vector<std::uint16_t> mColumnIndexTable;
+        //! 割り当てられる最大のEntity数
         std::size_t mMaxEntityNum;
-        //! ݂Entity
+        //! 現在のEntity数
         std::size_t mEntityNum;
-
-        //!  蓖ĂEntityIDAhX(destroyɉď)
-        std::vector<std::size_t*> mpEntityIDs;
+        //! 保持の仕方
+        StorageMode mStorageMode;
+        //! ページの場合の1ページあたりのEntity数(固定)
+        std::size_t mPageEntityNum;
+        //! 列の並べ方
+        ColumnLayout mColumnLayout;
+        //! AoSoAの場合の1ブロックあたりのEntity数(2の冪)
+        std::size_t mBlockEntityNum;
+        //! 行からブロックの添字を求めるシフト量(log2(mBlockEntityNum))
+        std::size_t mBlockShift;
+        //! AoSoAの場合の1ブロックのサイズ(バイト)
+        std::size_t mBlockStride;
+        //! reserveで確保した容量(これより小さくは自動で切り詰めない)
+        std::size_t mReservedEntityNum;
+        //! 容量の伸ばし方・切り詰め方
+        CapacityPolicy mCapacityPolicy;
+        //! 割り当て直しの統計
+        ReallocationStats mReallocationStats;
+
+        //! Entityの位置を登録するテーブル
+        EntityTable* mpEntityTable;
+        //! 変更バージョンの参照先(Worldが持つもの)
+        const std::uint64_t* mpChangeVersion;
+        //! メモリを確保するリソース
+        std::pmr::memory_resource* mpMemoryResource;
+        //! mpMemoryResourceが大きさを変更できる場合はそのポインタ(できない場合はnullptr)
+        ResizableMemoryResource* mpResizableMemoryResource;
+        //! 各行に割り当てたEntity(deallocateに応じて詰める)
+        std::pmr::vector<Entity> mEntities;
+        //! ComponentData型を追加した時の移動先Chunk(型のハッシュ, 移動先)
+        std::vector<std::pair<std::uint32_t, IChunk*>> mAddTransitions;
+        //! ComponentData型を削除した時の移動先Chunk(型のハッシュ, 移動先)
+        std::vector<std::pair<std::uint32_t, IChunk*>> mRemoveTransitions;
     };
 }  // namespace mvecs
 
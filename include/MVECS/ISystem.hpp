@@ -1,8 +1,10 @@
 #ifndef MVECS_MVECS_ISYSTEM_HPP_
 #define MVECS_MVECS_ISYSTEM_HPP_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "IComponentData.hpp"
 #include "Entity.hpp"
@@ -21,6 +23,9 @@ public:                                         \
     template <typename Key, typename Common>
     class ISystem
     {
+        //! 実行時の変更バージョンを記録するため
+        friend class World<Key, Common>;
+
     public:
         //! デフォルトコンストラクタはdelete
         ISystem() = delete;
@@ -32,11 +37,18 @@ public:                                         \
          */
         ISystem(World<Key, Common>* const pWorld, const int executionOrder = 0)
             : mpWorld(pWorld)
+            , mLastRunVersion(0)
             , mExecutionOrder(executionOrder)
             , mRemoveThisSystem(false)
         {
         }
 
+        /**
+         * @brief デストラクタ
+         *
+         */
+        virtual ~ISystem() = default;
+
         /**
          * @brief World初期化時 or Systemが追加された時に呼ばれるインタフェース
          *
@@ -68,16 +80,59 @@ public:                                         \
         //    mpWorld->template forEach<T>(func);
         //}
 
+        /**
+         * @brief 条件に一致するChunkの一覧(Query)を取得する
+         *
+         * @tparam Args 条件(ComponentData型、With、Without、Optional)
+         * @return const Query& 条件に一致するChunkの一覧(Worldにキャッシュされる)
+         */
+        template <typename... Args>
+        const Query& query()
+        {
+            return mpWorld->template query<Args...>();
+        }
+
         /**
          * @brief 複数のComponentData型に対するforEach
          * @warning 指定したComponentData型をすべて含むChunk(Entity)しか巡回されない
-         * @tparam Args 
-         * @param func 
+         * @tparam Args 読み書きする型(ComponentData型、Optional、Entity)
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数(ComponentData型はT&、Optional<T>はT*、EntityはEntityを受け取る)
+         * @param filters 絞り込みの条件
          */
-        template <typename... Args>
-        void forEach(const std::function<void(Args&...)>& func)
+        template <typename... Args, typename... Filters>
+        void forEach(const std::function<void(typename QueryTerm<Args>::Param...)>& func, Filters... filters)
+        {
+            mpWorld->template forEach<Args...>(func, filters...);
+        }
+
+        /**
+         * @brief 関数オブジェクトの引数の型から読み書きする型を求めるforEach
+         *
+         * @tparam Func 関数オブジェクトの型(operator()がテンプレートでないもの)
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数オブジェクト(引数はT&、const T&、T*かEntity)
+         * @param filters 絞り込みの条件
+         */
+        template <typename Func, typename... Filters, typename = typename CallableTraits<std::decay_t<Func>>::Terms>
+        void forEach(Func&& func, Filters... filters)
         {
-            mpWorld->template forEach<Args...>(func);
+            mpWorld->forEach(std::forward<Func>(func), filters...);
+        }
+
+        /**
+         * @brief 条件に一致するChunk毎に1回、各ComponentData型の配列をまとめて渡すforEach
+         *
+         * @tparam Args 読み書きするComponentData型
+         * @tparam Func 関数オブジェクトの型
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数オブジェクト((std::size_t entityNum, const Entity* pEntities, ComponentArray<Args>&...)で呼ばれる)
+         * @param filters 絞り込みの条件
+         */
+        template <typename... Args, typename Func, typename... Filters>
+        void forEachChunk(Func&& func, Filters... filters)
+        {
+            mpWorld->template forEachChunk<Args...>(std::forward<Func>(func), filters...);
         }
 
         /**
@@ -86,13 +141,24 @@ public:                                         \
          * @tparam T Component型
          * @tparam typename ComponentData判定用
          * @param func 実行する関数オブジェクト
+         * @param threadNum 使うスレッド数(0の場合はApplicationのThreadPoolの全スレッド)
          */
         template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
-        void forEachParallel(const std::function<void(T&)>& func, uint8_t threadNum = 4)
+        void forEachParallel(const std::function<void(T&)>& func, const std::size_t threadNum = 0)
         {
             mpWorld->template forEachParallel<T>(func, threadNum);
         }
 
+        /**
+         * @brief forEachParallelで1タスクに割り当てる最小の行数を設定する
+         *
+         * @param batchSize 行数(1以上)
+         */
+        void setParallelBatchSize(const std::size_t batchSize)
+        {
+            mpWorld->setParallelBatchSize(batchSize);
+        }
+
         /**
          * @brief Entity構築
          *
@@ -106,14 +172,74 @@ public:                                         \
             return mpWorld->template createEntity<Args...>(reserveSizeIfCreatedNewChunk);
         }
 
+        /**
+         * @brief 同じComponentData型を持つEntityをまとめて構築する
+         *
+         * @tparam Args Entityが持つComponentData
+         * @param count 構築するEntity数
+         * @return std::vector<Entity> 構築したEntity
+         */
+        template <typename... Args>
+        std::vector<Entity> createEntities(const std::size_t count)
+        {
+            return mpWorld->template createEntities<Args...>(count);
+        }
+
+        /**
+         * @brief 指定したComponentData型を持つEntityの保持の仕方を設定する
+         * @details その型のEntityを構築する前に呼ぶこと
+         * @tparam Args ComponentData型
+         * @param storageMode 保持の仕方
+         * @param pageSize ページの場合の1ページのバイト数
+         */
+        template <typename... Args>
+        void setStorageMode(const StorageMode storageMode, const std::size_t pageSize = World<Key, Common>::DefaultPageSize)
+        {
+            mpWorld->template setStorageMode<Args...>(storageMode, pageSize);
+        }
+
         /**
          * @brief Entityを破棄する
          *
          * @param entity 破棄するEntity
+         * @param mode Chunk内の行の詰め方(デフォルトで末尾の行を移動する)
+         */
+        void destroyEntity(const Entity& entity, RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            mpWorld->destroyEntity(entity, mode);
+        }
+
+        /**
+         * @brief 複数のEntityをまとめて破棄する
+         *
+         * @param entities 破棄するEntityたち
+         * @param mode Chunk内の行の詰め方(デフォルトで末尾の行を移動する)
+         */
+        void destroyEntities(const std::vector<Entity>& entities, RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            mpWorld->destroyEntities(entities, mode);
+        }
+
+        /**
+         * @brief 呼び出したスレッド用のCommandBufferを取得する
+         * @details forEach中やforEachParallelのスレッド内ではEntityの構築・破棄をこれに記録する(このSystemの更新後に反映される)
+         * @return CommandBuffer<Key, Common>&
+         */
+        CommandBuffer<Key, Common>& commandBuffer()
+        {
+            return mpWorld->getCommandBuffer();
+        }
+
+        /**
+         * @brief Entityがまだ生存しているかどうか判定する
+         *
+         * @param entity 判定するEntity
+         * @return true 生存している
+         * @return false 破棄済み
          */
-        void destroyEntity(const Entity& entity)
+        bool isAlive(const Entity& entity) const
         {
-            mpWorld->destroyEntity(entity);
+            return mpWorld->isAlive(entity);
         }
 
         /**
@@ -142,6 +268,33 @@ public:                                         \
             return mpWorld->template getComponentData<T>(entity);
         }
 
+        /**
+         * @brief EntityにComponentDataを追加する
+         *
+         * @tparam T 追加するComponentDataの型
+         * @param entity 追加先Entity(まだTを持たないこと)
+         * @param value 追加するComponentDataの値
+         * @param mode 移動元のChunk内の行の詰め方
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        void addComponentData(const Entity& entity, const T& value = T(), RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            mpWorld->template addComponentData<T>(entity, value, mode);
+        }
+
+        /**
+         * @brief EntityからComponentDataを削除する
+         *
+         * @tparam T 削除するComponentDataの型
+         * @param entity 削除先Entity(Tを持つこと)
+         * @param mode 移動元のChunk内の行の詰め方
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        void removeComponentData(const Entity& entity, RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            mpWorld->template removeComponentData<T>(entity, mode);
+        }
+
         /**
          * @brief Systemを追加する
          *
@@ -199,9 +352,21 @@ public:                                         \
             return mExecutionOrder;
         }
 
+        /**
+         * @brief 前回onUpdateを実行し終えた時のWorldの変更バージョンを取得する
+         * @details Changed<T>はこれより後に変更されたChunkのみを巡回する(まだ実行していなければ0)
+         * @return std::uint64_t 変更バージョン
+         */
+        std::uint64_t getLastRunVersion() const
+        {
+            return mLastRunVersion;
+        }
+
     private:
         //! Worldへのポインタ(SystemをWorld外で作成しないで)
         World<Key, Common>* const mpWorld;
+        //! 前回onUpdateを実行し終えた時のWorldの変更バージョン
+        std::uint64_t mLastRunVersion;
 
     protected:
         //! 実行する順序(小さい順に実行される)
@@ -4,8 +4,14 @@
 #include "MVECS/Application.hpp"
 #include "MVECS/Archetype.hpp"
 #include "MVECS/Chunk.hpp"
+#include "MVECS/CommandBuffer.hpp"
+#include "MVECS/ComponentRegistry.hpp"
+#include "MVECS/ComponentSignature.hpp"
 #include "MVECS/IComponentData.hpp"
 #include "MVECS/ISystem.hpp"
+#include "MVECS/MemoryResource.hpp"
+#include "MVECS/Query.hpp"
+#include "MVECS/ThreadPool.hpp"
 #include "MVECS/TypeInfo.hpp"
 #include "MVECS/World.hpp"
 
@@ -0,0 +1,274 @@
+#ifndef MVECS_MVECS_MEMORYRESOURCE_HPP_
+#define MVECS_MVECS_MEMORYRESOURCE_HPP_
+
+#include <cstddef>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace mvecs
+{
+    /**
+     * @brief Chunkのメモリ確保向けのプール
+     * @details Chunkの確保サイズは(全型のサイズの和)×(2の冪 もしくは ページのEntity数)になるため、
+     *          2の冪を4分割したサイズクラス(無駄は最大25%)毎に解放済みブロックを保持して再利用する
+     *          最大サイズを超える確保とアラインメントがPoolAlignmentを超える確保は上流にそのまま渡す
+     *          スレッドセーフではない(Chunkの構造変更はWorldのスレッドでのみ行われる)
+     */
+    class PoolMemoryResource : public std::pmr::memory_resource
+    {
+    public:
+        //! 最小のサイズクラス
+        static constexpr std::size_t MinBlockSize = 64;
+        //! デフォルトでプールする最大のサイズ
+        static constexpr std::size_t DefaultMaxBlockSize = 4 * 1024 * 1024;
+        //! プールするブロックのアラインメント(上流にはこのアラインメントで要求する)
+        static constexpr std::size_t PoolAlignment = 64;
+
+        /**
+         * @brief コンストラクタ
+         *
+         * @param maxBlockSize プールする最大のサイズ(これより大きい確保は上流に渡す)
+         * @param pUpstream 実際にメモリを確保する上流のリソース
+         */
+        explicit PoolMemoryResource(std::size_t maxBlockSize = DefaultMaxBlockSize, std::pmr::memory_resource* pUpstream = std::pmr::get_default_resource());
+
+        /**
+         * @brief デストラクタ(保持しているブロックを全て上流に返す)
+         *
+         */
+        ~PoolMemoryResource() override;
+
+        /**
+         * @brief コピーコンストラクタはdelete
+         *
+         * @param src
+         */
+        PoolMemoryResource(const PoolMemoryResource& src) = delete;
+
+        /**
+         * @brief 代入によるコピーもdelete
+         *
+         * @param src
+         * @return PoolMemoryResource&
+         */
+        PoolMemoryResource& operator=(const PoolMemoryResource& src) = delete;
+
+        /**
+         * @brief 保持している解放済みブロックを全て上流に返す
+         *
+         */
+        void release();
+
+        /**
+         * @brief 再利用のために保持しているバイト数を取得する
+         *
+         * @return std::size_t バイト数
+         */
+        std::size_t getCachedBytes() const;
+
+        /**
+         * @brief 上流のリソースを取得する
+         *
+         * @return std::pmr::memory_resource*
+         */
+        std::pmr::memory_resource* getUpstream() const;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    private:
+        /**
+         * @brief 解放済みブロック(ブロックの先頭に書き込む)
+         *
+         */
+        struct FreeBlock
+        {
+            FreeBlock* pNext;
+        };
+
+        /**
+         * @brief サイズを収められる最小のサイズクラスを取得する
+         *
+         * @param bytes サイズ
+         * @return std::size_t サイズクラス
+         */
+        static std::size_t getSizeClass(std::size_t bytes);
+
+        /**
+         * @brief サイズクラスのブロックサイズを取得する
+         *
+         * @param sizeClass サイズクラス
+         * @return std::size_t ブロックサイズ
+         */
+        static std::size_t getClassSize(std::size_t sizeClass);
+
+        /**
+         * @brief プールの対象かどうか
+         *
+         * @param bytes サイズ
+         * @param alignment アラインメント
+         * @return true プールする
+         * @return false 上流に渡す
+         */
+        bool isPooled(std::size_t bytes, std::size_t alignment) const;
+
+        //! サイズクラス毎の解放済みブロックのリスト
+        std::vector<FreeBlock*> mFreeLists;
+        //! 上流のリソース
+        std::pmr::memory_resource* mpUpstream;
+        //! プールする最大のサイズ
+        std::size_t mMaxBlockSize;
+        //! 保持しているバイト数
+        std::size_t mCachedBytes;
+    };
+
+    /**
+     * @brief 確保済みの領域の大きさを変更できるリソース
+     * @details Chunkはこれを使う場合、割り当て直し時に新しい領域への全コピーではなくresizeと列の移動を行う
+     *
+     */
+    class ResizableMemoryResource : public std::pmr::memory_resource
+    {
+    public:
+        /**
+         * @brief 確保済みの領域の大きさを変更する(先頭からmin(oldBytes, newBytes)の内容は保たれる)
+         *
+         * @param p allocateで確保した領域
+         * @param oldBytes 現在のサイズ
+         * @param newBytes 新しいサイズ
+         * @param alignment 確保した時のアラインメント
+         * @return void* 新しい領域(pと異なる場合、pは解放済み)
+         */
+        void* resize(void* p, std::size_t oldBytes, std::size_t newBytes, std::size_t alignment)
+        {
+            return do_resize(p, oldBytes, newBytes, alignment);
+        }
+
+    protected:
+        virtual void* do_resize(void* p, std::size_t oldBytes, std::size_t newBytes, std::size_t alignment) = 0;
+    };
+
+    /**
+     * @brief 大きな確保を匿名mmap(Huge Page)で行うリソース
+     * @details minMappedSize以上の確保はmmapしてMADV_HUGEPAGEを指定し(useHugeTLBならまずMAP_HUGETLBを試す)、
+     *          大きさの変更はmremapで行う(ページのコピーが発生しない)
+     *          それより小さい確保、mmapが使えない環境(Linux以外)、mmapに失敗した場合は上流にそのまま渡す
+     *          スレッドセーフではない
+     */
+    class HugePageMemoryResource : public ResizableMemoryResource
+    {
+    public:
+        //! Huge Pageのサイズ(x86-64, AArch64の標準)
+        static constexpr std::size_t HugePageSize = 2 * 1024 * 1024;
+
+        /**
+         * @brief コンストラクタ
+         *
+         * @param minMappedSize これ以上の確保をmmapで行う
+         * @param useHugeTLB 明示的なHuge Page(hugetlbfs)をまず試すかどうか
+         * @param pUpstream 小さい確保とフォールバックに使うリソース
+         */
+        explicit HugePageMemoryResource(std::size_t minMappedSize = HugePageSize, bool useHugeTLB = false, std::pmr::memory_resource* pUpstream = std::pmr::get_default_resource());
+
+        /**
+         * @brief デストラクタ(mmapした領域を全て解放する)
+         *
+         */
+        ~HugePageMemoryResource() override;
+
+        /**
+         * @brief コピーコンストラクタはdelete
+         *
+         * @param src
+         */
+        HugePageMemoryResource(const HugePageMemoryResource& src) = delete;
+
+        /**
+         * @brief 代入によるコピーもdelete
+         *
+         * @param src
+         * @return HugePageMemoryResource&
+         */
+        HugePageMemoryResource& operator=(const HugePageMemoryResource& src) = delete;
+
+        /**
+         * @brief mmapでの確保が使える環境かどうか
+         *
+         * @return true 使える
+         * @return false 全て上流に渡される
+         */
+        static bool isSupported();
+
+        /**
+         * @brief mmapした領域の合計サイズを取得する
+         *
+         * @return std::size_t バイト数
+         */
+        std::size_t getMappedBytes() const;
+
+        /**
+         * @brief 上流のリソースを取得する
+         *
+         * @return std::pmr::memory_resource*
+         */
+        std::pmr::memory_resource* getUpstream() const;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        void* do_resize(void* p, std::size_t oldBytes, std::size_t newBytes, std::size_t alignment) override;
+
+    private:
+        /**
+         * @brief mmapした領域
+         *
+         */
+        struct Mapping
+        {
+            //! 実際にmmapしたサイズ
+            std::size_t mappedBytes;
+            //! MAP_HUGETLBで確保したかどうか
+            bool hugeTLB;
+        };
+
+        /**
+         * @brief mmapで確保する(失敗したらnullptr)
+         *
+         * @param bytes サイズ
+         * @return void* 確保した領域
+         */
+        void* map(std::size_t bytes);
+
+        /**
+         * @brief mmapの対象かどうか
+         *
+         * @param bytes サイズ
+         * @param alignment アラインメント
+         * @return true mmapする
+         * @return false 上流に渡す
+         */
+        bool isMapped(std::size_t bytes, std::size_t alignment) const;
+
+        //! mmapした領域たち(先頭アドレス -> 領域)
+        std::unordered_map<void*, Mapping> mMappings;
+        //! 上流のリソース
+        std::pmr::memory_resource* mpUpstream;
+        //! これ以上の確保をmmapで行う
+        std::size_t mMinMappedSize;
+        //! まずMAP_HUGETLBを試すかどうか
+        bool mUseHugeTLB;
+        //! mmapした領域の合計サイズ
+        std::size_t mMappedBytes;
+    };
+}  // namespace mvecs
+
+#endif
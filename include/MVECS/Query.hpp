@@ -0,0 +1,487 @@
+#ifndef MVECS_MVECS_QUERY_HPP_
+#define MVECS_MVECS_QUERY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "Archetype.hpp"
+#include "ComponentArray.hpp"
+#include "ComponentRegistry.hpp"
+#include "ComponentSignature.hpp"
+#include "Entity.hpp"
+#include "IChunk.hpp"
+#include "IComponentData.hpp"
+
+namespace mvecs
+{
+    /**
+     * @brief 持っていなければならないが読み書きはしないComponentData型を表す(Queryのフィルタ)
+     *
+     * @tparam T ComponentData型
+     */
+    template <typename T>
+    struct With
+    {
+        static_assert(IsComponentDataType<T>, "T is not ComponentData type");
+    };
+
+    /**
+     * @brief 持っていてはならないComponentData型を表す(Queryのフィルタ)
+     *
+     * @tparam T ComponentData型
+     */
+    template <typename T>
+    struct Without
+    {
+        static_assert(IsComponentDataType<T>, "T is not ComponentData type");
+    };
+
+    /**
+     * @brief 持っていなければならず、前回のSystemの実行以降に書き込まれた(かもしれない)Chunkのみを巡回することを表す(Queryのフィルタ)
+     * @details 判定は列毎の変更バージョンでChunk単位に行うため、Chunk内の1行でも書き込み可能な形で渡されていれば巡回される
+     * @tparam T ComponentData型
+     */
+    template <typename T>
+    struct Changed
+    {
+        static_assert(IsComponentDataType<T>, "T is not ComponentData type");
+    };
+
+    /**
+     * @brief 持っていれば読み書きするComponentData型を表す(Queryのフィルタ、無い場合はnullptrが渡される)
+     *
+     * @tparam T ComponentData型(const Tなら読むだけで、列の変更バージョンを更新しない)
+     */
+    template <typename T>
+    struct Optional
+    {
+        static_assert(IsComponentDataType<std::remove_const_t<T>>, "T is not ComponentData type");
+    };
+
+    /**
+     * @brief Queryの条件の1項(ComponentData型、With、Without、Changed、Optional)の扱い
+     * @details 条件(持つべき型・持ってはならない型)への反映と、forEachでの引数の型・取り出し方を定める
+     *          どれもArchetype(Chunk)毎に1回だけ解決され、行毎には判定しない
+     * @tparam T ComponentData型(読み書きし、持っていなければならない)
+     */
+    template <typename T>
+    struct QueryTerm
+    {
+        static_assert(IsComponentDataType<T>, "T is not ComponentData type");
+
+        //! forEachに渡す引数の型
+        using Param = T&;
+        //! Chunk毎に取得する配列の型
+        using Array = ComponentArray<T>;
+        //! forEachの引数になるかどうか
+        static constexpr bool IsRead = true;
+
+        static void apply(ComponentSignature& required, ComponentSignature&)
+        {
+            required.set(ComponentRegistry::getID<T>());
+        }
+
+        static Array getArray(IChunk& chunk)
+        {
+            return chunk.getComponentArray<T>();
+        }
+
+        static T* getBlock(Array& array, const std::size_t block)
+        {
+            return array.getBlock(block);
+        }
+
+        static Param get(T* pBlock, const std::size_t i)
+        {
+            return pBlock[i];
+        }
+    };
+
+    /**
+     * @brief const Tの扱い(持っていなければならず、読むだけなので列の変更バージョンを更新しない)
+     *
+     * @tparam T ComponentData型
+     */
+    template <typename T>
+    struct QueryTerm<const T>
+    {
+        static_assert(IsComponentDataType<T>, "T is not ComponentData type");
+
+        using Param = const T&;
+        using Array = ComponentArray<const T>;
+        static constexpr bool IsRead = true;
+
+        static void apply(ComponentSignature& required, ComponentSignature&)
+        {
+            required.set(ComponentRegistry::getID<T>());
+        }
+
+        static Array getArray(IChunk& chunk)
+        {
+            return chunk.getComponentArray<const T>();
+        }
+
+        static const T* getBlock(Array& array, const std::size_t block)
+        {
+            return array.getBlock(block);
+        }
+
+        static Param get(const T* pBlock, const std::size_t i)
+        {
+            return pBlock[i];
+        }
+    };
+
+    /**
+     * @brief With<T>の扱い(持っていなければならないが読み書きしない)
+     *
+     * @tparam T ComponentData型
+     */
+    template <typename T>
+    struct QueryTerm<With<T>>
+    {
+        static constexpr bool IsRead = false;
+
+        static void apply(ComponentSignature& required, ComponentSignature&)
+        {
+            required.set(ComponentRegistry::getID<T>());
+        }
+
+        static bool accepts(const IChunk&, const std::uint64_t)
+        {
+            return true;
+        }
+    };
+
+    /**
+     * @brief Without<T>の扱い(持っていてはならない)
+     *
+     * @tparam T ComponentData型
+     */
+    template <typename T>
+    struct QueryTerm<Without<T>>
+    {
+        static constexpr bool IsRead = false;
+
+        static void apply(ComponentSignature&, ComponentSignature& excluded)
+        {
+            excluded.set(ComponentRegistry::getID<T>());
+        }
+
+        static bool accepts(const IChunk&, const std::uint64_t)
+        {
+            return true;
+        }
+    };
+
+    /**
+     * @brief Changed<T>の扱い(持っていなければならず、巡回毎にChunkの列の変更バージョンで絞り込む)
+     *
+     * @tparam T ComponentData型
+     */
+    template <typename T>
+    struct QueryTerm<Changed<T>>
+    {
+        static constexpr bool IsRead = false;
+
+        static void apply(ComponentSignature& required, ComponentSignature&)
+        {
+            required.set(ComponentRegistry::getID<T>());
+        }
+
+        static bool accepts(const IChunk& chunk, const std::uint64_t version)
+        {
+            return chunk.isChangedSince<T>(version);
+        }
+    };
+
+    /**
+     * @brief Optional<T>の扱い(条件には含めず、持たないChunkではnullptrを渡す)
+     *
+     * @tparam T ComponentData型(const Tなら列の変更バージョンを更新しない)
+     */
+    template <typename T>
+    struct QueryTerm<Optional<T>>
+    {
+        using Param = T*;
+        using Array = std::optional<ComponentArray<T>>;
+        static constexpr bool IsRead = true;
+
+        static void apply(ComponentSignature&, ComponentSignature&)
+        {
+        }
+
+        static Array getArray(IChunk& chunk)
+        {
+            if (!chunk.getArchetype().isIn<std::remove_const_t<T>>())
+            {
+                return std::nullopt;
+            }
+
+            return chunk.getComponentArray<T>();
+        }
+
+        static T* getBlock(Array& array, const std::size_t block)
+        {
+            return array ? array->getBlock(block) : nullptr;
+        }
+
+        static Param get(T* pBlock, const std::size_t i)
+        {
+            return pBlock ? pBlock + i : nullptr;
+        }
+    };
+
+    /**
+     * @brief Entityの扱い(条件には含めず、各行のEntityをChunkのEntityの列から渡す)
+     *
+     */
+    template <>
+    struct QueryTerm<Entity>
+    {
+        using Param = Entity;
+        //! Entityの列の先頭とブロック毎の要素数(Entityの列はAoSoAでも連続している)
+        struct Array
+        {
+            const Entity* pEntities;
+            std::size_t blockEntityNum;
+        };
+        static constexpr bool IsRead = true;
+
+        static void apply(ComponentSignature&, ComponentSignature&)
+        {
+        }
+
+        static Array getArray(IChunk& chunk)
+        {
+            const std::size_t blockEntityNum = chunk.getColumnLayout() == ColumnLayout::AoSoA ? chunk.getBlockEntityNum() : chunk.getEntityNum();
+            return Array{chunk.getEntities(), blockEntityNum};
+        }
+
+        static const Entity* getBlock(Array& array, const std::size_t block)
+        {
+            return array.pEntities + block * array.blockEntityNum;
+        }
+
+        static Param get(const Entity* pBlock, const std::size_t i)
+        {
+            return pBlock[i];
+        }
+    };
+
+    /**
+     * @brief forEachに渡す関数の引数の型から条件の項を求める(T&はT、const T&はconst T、T*はOptional<T>、const T*はOptional<const T>、EntityはEntity)
+     *
+     * @tparam Param 引数の型
+     */
+    template <typename Param>
+    struct QueryParam
+    {
+        static_assert(std::is_reference_v<Param> || std::is_pointer_v<Param>, "forEach parameter must be T&, T* or Entity!");
+    };
+
+    template <>
+    struct QueryParam<Entity>
+    {
+        using Term = Entity;
+    };
+
+    template <>
+    struct QueryParam<const Entity&>
+    {
+        using Term = Entity;
+    };
+
+    template <typename T>
+    struct QueryParam<T&>
+    {
+        using Term = T;
+    };
+
+    template <typename T>
+    struct QueryParam<T*>
+    {
+        using Term = Optional<T>;
+    };
+
+    /**
+     * @brief 関数オブジェクト(ラムダ式など)・関数ポインタの引数の型から条件の項の並びを求める
+     * @details Termsは条件の項のstd::tuple 関数として呼べない型やoperator()がテンプレート(ジェネリックラムダ)の型ではTermsを持たない
+     * @tparam Func 関数オブジェクトの型
+     */
+    template <typename Func, typename = void>
+    struct CallableTraits
+    {
+    };
+
+    template <typename Func>
+    struct CallableTraits<Func, std::void_t<decltype(&Func::operator())>> : CallableTraits<decltype(&Func::operator())>
+    {
+    };
+
+    template <typename R, typename... Params>
+    struct CallableTraits<R (*)(Params...)>
+    {
+        using Terms = std::tuple<typename QueryParam<Params>::Term...>;
+    };
+
+    template <typename C, typename R, typename... Params>
+    struct CallableTraits<R (C::*)(Params...)> : CallableTraits<R (*)(Params...)>
+    {
+    };
+
+    template <typename C, typename R, typename... Params>
+    struct CallableTraits<R (C::*)(Params...) const> : CallableTraits<R (*)(Params...)>
+    {
+    };
+
+    /**
+     * @brief Queryの条件(持っていなければならない型の集合と持っていてはならない型の集合)
+     *
+     */
+    struct QueryKey
+    {
+        //! 持っていなければならない型の集合
+        ComponentSignature required;
+        //! 持っていてはならない型の集合
+        ComponentSignature excluded;
+
+        /**
+         * @brief 条件の項から構築する
+         *
+         * @tparam Terms ComponentData型、With、Without、Changed、Optional
+         * @return QueryKey
+         */
+        template <typename... Terms>
+        static QueryKey create()
+        {
+            QueryKey rtn;
+            (QueryTerm<Terms>::apply(rtn.required, rtn.excluded), ...);
+
+            assert(!rtn.required.intersects(rtn.excluded) || !"the type is both required and excluded!");
+            return rtn;
+        }
+
+        bool operator==(const QueryKey& other) const
+        {
+            return required == other.required && excluded == other.excluded;
+        }
+
+        bool operator!=(const QueryKey& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    /**
+     * @brief 条件に一致するChunkの一覧を保持し続けるもの
+     * @details Worldが条件毎に1つだけ構築してキャッシュし、Chunkが構築された時にのみ一致判定して追加する
+     *          そのため毎回の巡回では全Chunkの一致判定を行わず、Withoutで除外されるChunkには触れない
+     */
+    class Query
+    {
+    public:
+        /**
+         * @brief コンストラクタ
+         *
+         * @param key 条件
+         */
+        explicit Query(const QueryKey& key)
+            : mKey(key)
+        {
+        }
+
+        /**
+         * @brief Archetypeが条件に一致するかどうか
+         *
+         * @param archetype 判定対象
+         * @return true 一致する
+         * @return false 一致しない
+         */
+        bool matches(const Archetype& archetype) const
+        {
+            const ComponentSignature& signature = archetype.getSignature();
+            return signature.contains(mKey.required) && !signature.intersects(mKey.excluded);
+        }
+
+        /**
+         * @brief Chunkが条件に一致すれば一覧に追加する(Chunkを構築した時にWorldが呼ぶ)
+         *
+         * @param pChunk 構築したChunk
+         * @return true 追加した
+         * @return false 一致しないので追加しなかった
+         */
+        bool tryAddChunk(IChunk* pChunk)
+        {
+            if (!matches(pChunk->getArchetype()))
+            {
+                return false;
+            }
+
+            mpChunks.emplace_back(pChunk);
+            return true;
+        }
+
+        /**
+         * @brief 条件に一致するChunkの一覧を取得する(構築した順)
+         *
+         * @return const std::vector<IChunk*>&
+         */
+        const std::vector<IChunk*>& getChunks() const
+        {
+            return mpChunks;
+        }
+
+        /**
+         * @brief 条件に一致するEntityの個数を取得する
+         *
+         * @return std::size_t 個数
+         */
+        std::size_t getEntityNum() const
+        {
+            std::size_t rtn = 0;
+            for (const auto pChunk : mpChunks)
+            {
+                rtn += pChunk->getEntityNum();
+            }
+
+            return rtn;
+        }
+
+        /**
+         * @brief 条件を取得する
+         *
+         * @return const QueryKey&
+         */
+        const QueryKey& getKey() const
+        {
+            return mKey;
+        }
+
+    private:
+        //! 条件
+        QueryKey mKey;
+        //! 条件に一致するChunkたち
+        std::vector<IChunk*> mpChunks;
+    };
+}  // namespace mvecs
+
+/**
+ * @brief QueryKeyをstd::unordered_mapのキーにするための特殊化
+ *
+ */
+template <>
+struct std::hash<mvecs::QueryKey>
+{
+    std::size_t operator()(const mvecs::QueryKey& key) const noexcept
+    {
+        return key.required.getHash() ^ (key.excluded.getHash() * 31);
+    }
+};
+
+#endif
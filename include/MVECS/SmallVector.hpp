@@ -0,0 +1,306 @@
+#ifndef MVECS_MVECS_SMALLVECTOR_HPP_
+#define MVECS_MVECS_SMALLVECTOR_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace mvecs
+{
+    /**
+     * @brief N個までは自身の中に、それを超えるとヒープに要素を持つ可変長配列
+     * @details 要素数が少ない場合はヒープ確保もポインタの間接参照の追加も無い(Archetypeの型情報の保持に使う)
+     *          Tはデフォルト構築・コピー・ムーブできる型であること
+     * @tparam T 要素の型
+     * @tparam N 自身の中に持つ要素数
+     */
+    template <typename T, std::size_t N>
+    class SmallVector
+    {
+    public:
+        static_assert(N != 0, "inline capacity must not be 0");
+        static_assert(std::is_default_constructible_v<T>, "T must be default constructible");
+
+        //! iterator型の定義
+        using iterator       = T*;
+        //! const_iterator型の定義
+        using const_iterator = const T*;
+
+        /**
+         * @brief コンストラクタ(空)
+         *
+         */
+        SmallVector()
+            : mpData(mInlineData)
+            , mSize(0)
+            , mCapacity(N)
+        {
+        }
+
+        /**
+         * @brief デストラクタ
+         *
+         */
+        ~SmallVector()
+        {
+            release();
+        }
+
+        /**
+         * @brief コピーコンストラクタ
+         *
+         * @param src コピー元
+         */
+        SmallVector(const SmallVector& src)
+            : SmallVector()
+        {
+            reserve(src.mSize);
+            std::copy(src.begin(), src.end(), mpData);
+            mSize = src.mSize;
+        }
+
+        /**
+         * @brief ムーブコンストラクタ(ヒープに持っている場合はメモリを引き継ぐ)
+         *
+         * @param src ムーブ元
+         */
+        SmallVector(SmallVector&& src) noexcept
+            : SmallVector()
+        {
+            moveFrom(std::move(src));
+        }
+
+        /**
+         * @brief コピー代入
+         *
+         * @param src コピー元
+         * @return SmallVector&
+         */
+        SmallVector& operator=(const SmallVector& src)
+        {
+            if (this != &src)
+            {
+                clear();
+                reserve(src.mSize);
+                std::copy(src.begin(), src.end(), mpData);
+                mSize = src.mSize;
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief ムーブ代入
+         *
+         * @param src ムーブ元
+         * @return SmallVector&
+         */
+        SmallVector& operator=(SmallVector&& src) noexcept
+        {
+            if (this != &src)
+            {
+                release();
+                moveFrom(std::move(src));
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief 末尾に要素を追加する
+         *
+         * @param value 追加する要素
+         */
+        void push_back(const T& value)
+        {
+            if (mSize == mCapacity)
+            {
+                reserve(mCapacity * 2);
+            }
+
+            mpData[mSize++] = value;
+        }
+
+        /**
+         * @brief 少なくともcapacity個の要素を割り当て直さずに持てるようにする
+         *
+         * @param capacity 要素数
+         */
+        void reserve(const std::size_t capacity)
+        {
+            if (capacity <= mCapacity)
+            {
+                return;
+            }
+
+            T* const pNew = new T[capacity];
+            std::move(begin(), end(), pNew);
+
+            const std::size_t size = mSize;
+            release();
+            mpData    = pNew;
+            mSize     = size;
+            mCapacity = capacity;
+        }
+
+        /**
+         * @brief 全ての要素を削除する(確保したメモリはそのまま)
+         *
+         */
+        void clear()
+        {
+            mSize = 0;
+        }
+
+        /**
+         * @brief []のオーバーロード
+         *
+         * @param index 添字
+         * @return T&
+         */
+        T& operator[](const std::size_t index)
+        {
+            assert(index < mSize);
+            return mpData[index];
+        }
+
+        /**
+         * @brief []のオーバーロード(const)
+         *
+         * @param index 添字
+         * @return const T&
+         */
+        const T& operator[](const std::size_t index) const
+        {
+            assert(index < mSize);
+            return mpData[index];
+        }
+
+        /**
+         * @brief 要素数を取得する
+         *
+         * @return std::size_t 要素数
+         */
+        std::size_t size() const
+        {
+            return mSize;
+        }
+
+        /**
+         * @brief 空かどうか
+         *
+         * @return true 空
+         * @return false 空でない
+         */
+        bool empty() const
+        {
+            return mSize == 0;
+        }
+
+        /**
+         * @brief 要素を自身の中に持っているかどうか(ヒープを使っていないか)
+         *
+         * @return true 自身の中に持っている
+         * @return false ヒープに持っている
+         */
+        bool isInline() const
+        {
+            return mpData == mInlineData;
+        }
+
+        /**
+         * @brief 先頭イテレータを取得する
+         *
+         * @return iterator
+         */
+        iterator begin() noexcept
+        {
+            return mpData;
+        }
+
+        /**
+         * @brief 終端イテレータを取得する
+         *
+         * @return iterator
+         */
+        iterator end() noexcept
+        {
+            return mpData + mSize;
+        }
+
+        /**
+         * @brief const先頭イテレータを取得する
+         *
+         * @return const_iterator
+         */
+        const_iterator begin() const noexcept
+        {
+            return mpData;
+        }
+
+        /**
+         * @brief const終端イテレータを取得する
+         *
+         * @return const_iterator
+         */
+        const_iterator end() const noexcept
+        {
+            return mpData + mSize;
+        }
+
+    private:
+        /**
+         * @brief ヒープに確保したメモリを解放して空にする
+         *
+         */
+        void release()
+        {
+            if (!isInline())
+            {
+                delete[] mpData;
+            }
+
+            mpData    = mInlineData;
+            mSize     = 0;
+            mCapacity = N;
+        }
+
+        /**
+         * @brief srcの要素を引き継ぐ(thisは空であること)
+         *
+         * @param src ムーブ元(空になる)
+         */
+        void moveFrom(SmallVector&& src) noexcept
+        {
+            if (src.isInline())
+            {
+                std::move(src.begin(), src.end(), mInlineData);
+            }
+            else
+            {
+                mpData    = src.mpData;
+                mCapacity = src.mCapacity;
+
+                src.mpData    = src.mInlineData;
+                src.mCapacity = N;
+            }
+
+            mSize     = src.mSize;
+            src.mSize = 0;
+        }
+
+        //! 要素の先頭(mInlineDataかヒープ)
+        T* mpData;
+        //! 要素数
+        std::size_t mSize;
+        //! 割り当て直さずに持てる要素数
+        std::size_t mCapacity;
+        //! 自身の中に持つ要素
+        T mInlineData[N];
+    };
+}  // namespace mvecs
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef MVECS_MVECS_THREADPOOL_HPP_
+#define MVECS_MVECS_THREADPOOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mvecs
+{
+    /**
+     * @brief 常駐するワーカースレッドたち(forEachParallelで使う)
+     * @details ワーカーは構築時に1回だけ作られ、仕事が無い間は条件変数で待機する
+     *          そのため並列実行の度にスレッドを構築・joinするコストがかからない
+     *          runを呼んだスレッドも0番目のスレッドとして仕事を行う
+     *          runTasksは細かい仕事(タスク)の列をスレッド毎のキューに分け、空いたスレッドが他のキューから盗んで実行する
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * @brief コンストラクタ
+         *
+         * @param threadNum 呼び出し元を含めたスレッド数(0の場合はstd::thread::hardware_concurrency())
+         */
+        explicit ThreadPool(std::size_t threadNum = 0);
+
+        /**
+         * @brief デストラクタ(ワーカーを終了させてjoinする)
+         *
+         */
+        ~ThreadPool();
+
+        /**
+         * @brief コピーコンストラクタはdelete
+         *
+         * @param src
+         */
+        ThreadPool(const ThreadPool& src) = delete;
+
+        /**
+         * @brief 代入によるコピーもdelete
+         *
+         * @param src
+         * @return ThreadPool&
+         */
+        ThreadPool& operator=(const ThreadPool& src) = delete;
+
+        /**
+         * @brief 全スレッドでjobを1回ずつ実行し、全て終わるまで待つ
+         * @details jobは(std::size_t threadIndex)で呼ばれ、threadIndexは[0, getThreadNum())(0は呼び出し元)
+         *          複数のスレッドから同時に呼ばれた場合は順に実行される
+         *          jobが例外を投げた場合、全スレッドが終わるのを待ってから最初の例外を呼び出し元のスレッドで投げ直す
+         * @warning jobの中からrunを呼ばないこと
+         * @param job 実行する関数
+         */
+        void run(const std::function<void(std::size_t)>& job);
+
+        /**
+         * @brief taskNum個のタスクを各スレッドのキューに分けて実行し、全て終わるまで待つ
+         * @details タスクの添字はスレッド毎に連続した範囲で配られ、各スレッドは自分のキューの先頭から順に実行する
+         *          自分のキューが空になったら、他のスレッドのキューの末尾から残りの半分を盗む(重いタスクが偏っても遊ぶスレッドが出にくい)
+         *          taskは(std::size_t taskIndex)で呼ばれ、各taskIndexについて高々1回呼ばれる
+         *          taskが例外を投げた場合、まだ始まっていないタスクは実行せず、全スレッドが終わるのを待ってから最初の例外を呼び出し元のスレッドで投げ直す
+         * @warning taskの中からrun・runTasksを呼ばないこと
+         * @param taskNum タスク数
+         * @param task 実行する関数
+         * @param threadNum 使うスレッド数(0の場合は全スレッド、getThreadNum()より多くは使えない)
+         */
+        void runTasks(const std::size_t taskNum, const std::function<void(std::size_t)>& task, const std::size_t threadNum = 0);
+
+        /**
+         * @brief 呼び出し元を含めたスレッド数を取得する
+         *
+         * @return std::size_t スレッド数
+         */
+        std::size_t getThreadNum() const;
+
+    private:
+        /**
+         * @brief スレッド毎のタスクのキュー(まだ実行していないタスクの添字の範囲)
+         * @details 持ち主は先頭から1つずつ取り、他のスレッドは末尾から盗む 範囲の読み書きはmutexで排他する
+         *          隣のスレッドのキューと同じキャッシュラインに載らないように並べる
+         */
+        struct alignas(64) TaskQueue
+        {
+            //! beginとendの排他制御
+            std::mutex mutex;
+            //! 次に持ち主が実行するタスク
+            std::size_t begin = 0;
+            //! 範囲の末尾(この手前から盗まれる)
+            std::size_t end = 0;
+        };
+
+        /**
+         * @brief 全スレッドでjobを1回ずつ実行し、全て終わるまで待つ(mRunMutexをロックした状態で呼ぶ)
+         *
+         * @param job 実行する関数
+         */
+        void dispatch(const std::function<void(std::size_t)>& job);
+
+        /**
+         * @brief jobを実行し、投げられた例外を記録する(最初の1つのみ、以降のrunTasksのタスクは中止する)
+         *
+         * @param job 実行する関数
+         * @param threadIndex スレッドの添字
+         */
+        void execute(const std::function<void(std::size_t)>& job, const std::size_t threadIndex);
+
+        /**
+         * @brief 自分のキューの先頭からタスクを1つ取る
+         *
+         * @param queue 自分のキュー
+         * @param taskIndex 取ったタスク
+         * @return true 取れた
+         * @return false キューが空
+         */
+        static bool pop(TaskQueue& queue, std::size_t& taskIndex);
+
+        /**
+         * @brief 他のスレッドのキューの末尾から残りの半分を盗み、自分のキューに移す
+         *
+         * @param threadIndex 自分のスレッドの添字
+         * @param threadNum タスクを実行しているスレッド数
+         * @return true 盗めた
+         * @return false 全てのキューが空
+         */
+        bool steal(const std::size_t threadIndex, const std::size_t threadNum);
+
+        /**
+         * @brief ワーカーの処理(仕事が来るまで待機し、来たら実行する)
+         *
+         * @param threadIndex スレッドの添字(1から)
+         */
+        void work(const std::size_t threadIndex);
+
+        //! ワーカーたち(呼び出し元のスレッドは含まない)
+        std::vector<std::thread> mWorkers;
+        //! スレッド毎のタスクのキュー(runTasksで使う、呼び出し元の分も含む)
+        std::unique_ptr<TaskQueue[]> mpTaskQueues;
+
+        //! run・runTasksの排他制御(同時に1つの仕事しか実行しない)
+        std::mutex mRunMutex;
+        //! 以下の状態の排他制御
+        std::mutex mMutex;
+        //! 仕事が来たこと(もしくは終了すること)をワーカーに通知する
+        std::condition_variable mWakeCondition;
+        //! 全てのワーカーが仕事を終えたことを呼び出し元に通知する
+        std::condition_variable mDoneCondition;
+
+        //! 実行中の仕事
+        const std::function<void(std::size_t)>* mpJob;
+        //! 仕事を出す度に進む番号(ワーカーは自分が最後に実行した番号と比べて新しい仕事かを判定する)
+        std::uint64_t mGeneration;
+        //! まだ仕事を終えていないワーカーの数
+        std::size_t mPendingNum;
+        //! 実行中の仕事で最初に投げられた例外(dispatchが呼び出し元で投げ直す)
+        std::exception_ptr mpException;
+        //! trueの時、runTasksの残りのタスクは実行しない(例外が投げられた)
+        std::atomic<bool> mCancelled;
+        //! trueの時、ワーカーは終了する
+        bool mStopped;
+    };
+}  // namespace mvecs
+
+#endif
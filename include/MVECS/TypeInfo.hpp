@@ -1,10 +1,16 @@
 #ifndef MVECS_MVECS_TYPEINFO_HPP_
 #define MVECS_MVECS_TYPEINFO_HPP_
 
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
+#include <new>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 
 //! ComponentDataには必ずこれらを定義すること
 #define COMPONENT_DATA(T)                                            \
@@ -132,19 +138,33 @@ namespace mvecs
     }  // namespace CompileTimeHash
 
     /**
-     * @brief 型のIDとそのサイズを取得できる情報
-     * 
+     * @brief 型のIDとそのサイズ・アラインメント、構築・破棄・移動の関数を取得できる情報
+     * @details 構築・破棄・移動は型を消去した関数ポインタで行うため、実行時に組み立てたArchetypeのChunkでも使える
+     *          関数はいずれも連続する要素の範囲を受け取るので、Chunkの列の範囲毎に1回の間接呼び出しで済む
      */
     struct TypeInfo
     {
     private:
+        //! count個の要素をデフォルト構築する関数
+        using ConstructFunc = void (*)(std::byte*, std::size_t);
+        //! count個の要素を破棄する関数
+        using DestructFunc = void (*)(std::byte*, std::size_t);
+        //! 移動元のcount個の要素を移動先にムーブ構築し、移動元を破棄する関数
+        using RelocateFunc = void (*)(std::byte*, std::byte*, std::size_t);
+
         /**
          * @brief 使用する型がTypeInfo制約をクリアしているかどうか判定できないためprivate
          * 
          */
-        constexpr TypeInfo(std::size_t size, std::uint32_t hash)
+        constexpr TypeInfo(std::size_t size, std::size_t alignment, std::uint32_t hash, ConstructFunc construct, DestructFunc destruct, RelocateFunc relocate, bool triviallyCopyable, bool triviallyDestructible)
             : mSize(size)
+            , mAlignment(alignment)
             , mTypeHash(hash)
+            , mConstruct(construct)
+            , mDestruct(destruct)
+            , mRelocate(relocate)
+            , mTriviallyCopyable(triviallyCopyable)
+            , mTriviallyDestructible(triviallyDestructible)
         {
         }
 
@@ -155,7 +175,13 @@ namespace mvecs
          */
         constexpr TypeInfo()
             : mSize(0)
+            , mAlignment(1)
             , mTypeHash(0)
+            , mConstruct(nullptr)
+            , mDestruct(nullptr)
+            , mRelocate(nullptr)
+            , mTriviallyCopyable(true)
+            , mTriviallyDestructible(true)
         {
         }
 
@@ -193,7 +219,7 @@ namespace mvecs
         template <typename T, typename = std::enable_if_t<TypeBinding::HasTypeInfoValue<T>>>
         static constexpr TypeInfo create()
         {
-            return TypeInfo(sizeof(T), T::getTypeHash());
+            return TypeInfo(sizeof(T), alignof(T), T::getTypeHash(), &constructImpl<T>, &destructImpl<T>, &relocateImpl<T>, std::is_trivially_copyable_v<T>, std::is_trivially_destructible_v<T>);
         }
 
         /**
@@ -216,11 +242,153 @@ namespace mvecs
             return mSize;
         }
 
+        /**
+         * @brief 型のアラインメントを取得
+         * 
+         * @return constexpr std::size_t 
+         */
+        constexpr std::size_t getAlignment() const
+        {
+            return mAlignment;
+        }
+
+        /**
+         * @brief trivially copyableかどうか(memcpyで移動できるかどうか)
+         *
+         * @return true trivially copyable
+         * @return false ムーブ構築と破棄が必要
+         */
+        constexpr bool isTriviallyCopyable() const
+        {
+            return mTriviallyCopyable;
+        }
+
+        /**
+         * @brief trivially destructibleかどうか(破棄が不要かどうか)
+         *
+         * @return true 破棄が不要
+         * @return false デストラクタを呼ぶ必要がある
+         */
+        constexpr bool isTriviallyDestructible() const
+        {
+            return mTriviallyDestructible;
+        }
+
+        /**
+         * @brief このアドレスから連続するcount個の要素をデフォルト構築する
+         * @details trivialな型はゼロクリアのみ行う
+         * @param ptr 先頭アドレス
+         * @param count 要素数
+         */
+        void construct(std::byte* ptr, std::size_t count) const
+        {
+            mConstruct(ptr, count);
+        }
+
+        /**
+         * @brief このアドレスから連続するcount個の要素を破棄する(trivially destructibleな型では何もしない)
+         *
+         * @param ptr 先頭アドレス
+         * @param count 要素数
+         */
+        void destruct(std::byte* ptr, std::size_t count = 1) const
+        {
+            if (!mTriviallyDestructible)
+            {
+                mDestruct(ptr, count);
+            }
+        }
+
+        /**
+         * @brief srcから連続するcount個の要素をdstにムーブ構築し、srcの要素を破棄する
+         * @details 先頭の要素から順に移動するため、dstがsrcより前であれば範囲が重なっていてもよい
+         *          trivially copyableな型はmemmoveのみ行う
+         * @param src 移動元の先頭アドレス
+         * @param dst 移動先の先頭アドレス(未構築であること)
+         * @param count 要素数
+         */
+        void relocate(std::byte* src, std::byte* dst, std::size_t count = 1) const
+        {
+            if (mTriviallyCopyable)
+            {
+                std::memmove(dst, src, mSize * count);
+                return;
+            }
+
+            mRelocate(src, dst, count);
+        }
+
     private:
+        /**
+         * @brief constructの実装
+         *
+         * @tparam T 型
+         */
+        template <typename T>
+        static void constructImpl(std::byte* ptr, std::size_t count)
+        {
+            if constexpr (std::is_trivially_default_constructible_v<T>)
+            {
+                std::memset(ptr, 0, sizeof(T) * count);
+            }
+            else
+            {
+                T* p = reinterpret_cast<T*>(ptr);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    new (p + i) T();
+                }
+            }
+        }
+
+        /**
+         * @brief destructの実装
+         *
+         * @tparam T 型
+         */
+        template <typename T>
+        static void destructImpl(std::byte* ptr, std::size_t count)
+        {
+            T* p = reinterpret_cast<T*>(ptr);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                p[i].~T();
+            }
+        }
+
+        /**
+         * @brief relocateの実装
+         *
+         * @tparam T 型
+         */
+        template <typename T>
+        static void relocateImpl(std::byte* src, std::byte* dst, std::size_t count)
+        {
+            T* pSrc = reinterpret_cast<T*>(src);
+            T* pDst = reinterpret_cast<T*>(dst);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                new (pDst + i) T(std::move(pSrc[i]));
+                pSrc[i].~T();
+            }
+        }
+
         //! 型のサイズ
         std::size_t mSize;
+        //! 型のアラインメント
+        std::size_t mAlignment;
         //! 型のハッシュ値
         std::uint32_t mTypeHash;
+        //! デフォルト構築する関数
+        ConstructFunc mConstruct;
+        //! 破棄する関数
+        DestructFunc mDestruct;
+        //! ムーブ構築して移動元を破棄する関数
+        RelocateFunc mRelocate;
+        //! trivially copyableかどうか
+        bool mTriviallyCopyable;
+        //! trivially destructibleかどうか
+        bool mTriviallyDestructible;
     };
 
 }  // namespace mvecs
@@ -2,14 +2,24 @@
 #define MVECS_MVECS_WORLD_HPP_
 
 #include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
 #include "Chunk.hpp"
+#include "CommandBuffer.hpp"
 #include "ComponentArray.hpp"
+#include "EntityTable.hpp"
+#include "Query.hpp"
+#include "ThreadPool.hpp"
 
 namespace mvecs
 {
@@ -33,11 +43,19 @@ namespace mvecs
     public:
         /**
          * @brief コンストラクタ
-         *
+         * @details ChunkのComponentData・行の管理情報とEntityTableのメモリはpMemoryResourceから確保される
+         *          リソースはWorldより長く生存している必要がある
+         * @param pApplication Applicationのポインタ
+         * @param pMemoryResource メモリを確保するリソース(nullptrの場合はstd::pmr::get_default_resource())
          */
-        World(Application<Key, Common>* pApplication)
-            : mIsRunning(false)
-            , mpApplication(pApplication)
+        World(Application<Key, Common>* pApplication, std::pmr::memory_resource* pMemoryResource = nullptr)
+            : mpApplication(pApplication)
+            , mpMemoryResource(pMemoryResource ? pMemoryResource : std::pmr::get_default_resource())
+            , mEntityTable(mpMemoryResource)
+            , mChangeVersion(1)
+            , mLastRunVersion(0)
+            , mParallelBatchSize(DefaultParallelBatchSize)
+            , mIsRunning(false)
         {
         }
 
@@ -61,32 +79,339 @@ namespace mvecs
         template <typename... Args>
         Entity createEntity(const std::size_t reserveSizeIfCreatedNewChunk = 1)
         {
-            constexpr Archetype archetype = Archetype::create<Args...>();
+            return getOrCreateChunk<Args...>(reserveSizeIfCreatedNewChunk)->allocate();
+        }
+
+        /**
+         * @brief 同じComponentData型を持つEntityをまとめて構築する
+         * @details Chunkの検索と容量の確保は1回だけ行われ、ComponentDataは列単位でまとめて構築される
+         * @tparam Args Entityが持つComponentData
+         * @param count 構築するEntity数
+         * @return std::vector<Entity> 構築したEntity(Chunk内の行の順)
+         */
+        template <typename... Args>
+        std::vector<Entity> createEntities(const std::size_t count)
+        {
+            std::vector<Entity> rtn;
+            rtn.reserve(count);
+
+            // ページの場合は空きのあるページから順に埋める
+            for (std::size_t rest = count; rest > 0;)
+            {
+                IChunk* const pChunk = getOrCreateChunk<Args...>(rest);
+                const std::size_t num = std::min(rest, pChunk->getAllocatableEntityNum());
+
+                pChunk->allocate(num, rtn);
+                rest -= num;
+            }
+
+            return rtn;
+        }
+
+        /**
+         * @brief 指定したComponentData型を持つEntityの保持の仕方を設定する
+         * @details その型のEntityを構築する前に呼ぶこと
+         *          ページの場合、1ページあたりのEntity数はpageSize / (ComponentDataのサイズの総和)になる
+         * @tparam Args ComponentData型
+         * @param storageMode 保持の仕方
+         * @param pageSize ページの場合の1ページのバイト数
+         */
+        template <typename... Args>
+        void setStorageMode(const StorageMode storageMode, const std::size_t pageSize = DefaultPageSize)
+        {
+            const Archetype& archetype = Archetype::get<Args...>();
+
+            ArchetypeRecord& record = getArchetypeRecord(archetype);
+            assert(record.pChunks.empty() || !"storage mode must be set before creating entities of the archetype!");
+
+            ArchetypeSettings& settings = record.settings;
+            settings.storageMode        = storageMode;
+            settings.pageSize           = pageSize;
+        }
+
+        /**
+         * @brief 指定したComponentData型を持つEntityのChunk内での列の並べ方を設定する
+         * @details その型のEntityを構築する前に呼ぶこと
+         *          AoSoAの場合、各ComponentDataをblockEntityNum行ずつ順に並べたブロックを繰り返す(同時に読む小さいComponentDataが近くに並ぶ)
+         *          ComponentArrayの添字・getBlockによるアクセスは並べ方によらず同じように扱える(イテレータはSoAの場合のみ)
+         * @tparam Args ComponentData型
+         * @param columnLayout 列の並べ方
+         * @param blockEntityNum AoSoAの場合の1ブロックあたりのEntity数(2の冪)
+         */
+        template <typename... Args>
+        void setColumnLayout(const ColumnLayout columnLayout, const std::size_t blockEntityNum = IChunk::DefaultBlockEntityNum)
+        {
+            const Archetype& archetype = Archetype::get<Args...>();
+
+            ArchetypeRecord& record = getArchetypeRecord(archetype);
+            assert(record.pChunks.empty() || !"column layout must be set before creating entities of the archetype!");
+            assert((blockEntityNum != 0 && (blockEntityNum & (blockEntityNum - 1)) == 0) || !"block entity num must be a power of 2!");
+
+            ArchetypeSettings& settings = record.settings;
+            settings.columnLayout       = columnLayout;
+            settings.blockEntityNum     = blockEntityNum;
+        }
+
+        /**
+         * @brief 指定したComponentData型を持つEntityのChunkの容量の伸ばし方・切り詰め方を設定する
+         * @details 既に構築されているChunkにも適用される
+         * @tparam Args ComponentData型
+         * @param policy 容量の伸ばし方・切り詰め方
+         */
+        template <typename... Args>
+        void setCapacityPolicy(const CapacityPolicy& policy)
+        {
+            const Archetype& archetype = Archetype::get<Args...>();
+
+            ArchetypeRecord& record = getArchetypeRecord(archetype);
+            record.settings.capacityPolicy = policy;
+
+            for (auto& pChunk : record.pChunks)
+            {
+                pChunk->setCapacityPolicy(policy);
+            }
+        }
+
+        /**
+         * @brief 指定したComponentData型を持つEntityを合計entityNum個まで割り当て直さずに構築できるようにする
+         * @details 連続領域の場合、確保した容量はshrinkToFitを呼ぶまで自動では切り詰められない
+         *          ページの場合は足りない分のページを追加する
+         * @tparam Args ComponentData型
+         * @param entityNum Entity数
+         */
+        template <typename... Args>
+        void reserve(const std::size_t entityNum)
+        {
+            const Archetype& archetype = Archetype::get<Args...>();
 
-            for (auto& e : mpChunks)
+            const ArchetypeRecord& record = getArchetypeRecord(archetype);
+            if (record.settings.storageMode == StorageMode::Contiguous)
             {
-                if (e->getArchetype() == archetype)
+                getOrCreateChunk<Args...>(entityNum)->reserve(entityNum);
+                return;
+            }
+
+            std::size_t capacity = 0;
+            for (const auto& pChunk : record.pChunks)
+            {
+                capacity += pChunk->getEntityNum() + pChunk->getAllocatableEntityNum();
+            }
+
+            while (capacity < entityNum)
+            {
+                IChunk* const pChunk = createChunk<Args...>(1);
+                capacity += pChunk->getAllocatableEntityNum();
+            }
+        }
+
+        /**
+         * @brief 全てのChunkの容量をEntity数まで切り詰める(reserveした容量も解放する)
+         * @details ページの場合は空のページのメモリのみ解放する
+         */
+        void shrinkToFit()
+        {
+            for (auto& pChunk : mpChunks)
+            {
+                pChunk->shrinkToFit();
+            }
+        }
+
+        /**
+         * @brief 指定したComponentData型を持つEntityのChunkの割り当て直しの統計を取得する
+         *
+         * @tparam Args ComponentData型
+         * @return ReallocationStats 全てのChunk(ページ)の合計
+         */
+        template <typename... Args>
+        ReallocationStats getReallocationStats() const
+        {
+            const Archetype& archetype = Archetype::get<Args...>();
+
+            ReallocationStats rtn;
+            if (auto itr = mArchetypeRecords.find(archetype.getSignature()); itr != mArchetypeRecords.end())
+            {
+                for (const auto& pChunk : itr->second.pChunks)
                 {
-                    return e->allocate();
+                    rtn += pChunk->getReallocationStats();
                 }
             }
 
-            auto* p = new Chunk<Args...>(Chunk<Args...>::create(genChunkID(), archetype, reserveSizeIfCreatedNewChunk));
-
-            return insertChunk(p)->allocate();
+            return rtn;
         }
 
         /**
          * @brief Entityを破棄する
          *
          * @param entity 破棄するEntity
+         * @param mode Chunk内の行の詰め方(デフォルトで末尾の行を移動する)
          */
-        void destroyEntity(const Entity& entity)
+        void destroyEntity(const Entity& entity, RemovalMode mode = RemovalMode::SwapAndPop)
         {
-            mpChunks[findChunk(entity.getChunkID())]->deallocate(entity);
-            //auto& chunk = mpChunks[findChunk(entity.getChunkID())];
-            //chunk->deallocate(entity);
-            // mpChunks.find(entity.getChunkID())->second.deallocate(entity);
+            assert(mEntityTable.isAlive(entity) || !"this entity was already destroyed!");
+            mEntityTable.getChunk(entity)->deallocate(entity, mode);
+        }
+
+        /**
+         * @brief 複数のEntityをまとめて破棄する
+         * @details Chunk毎にまとめ、各Chunkは1回の走査でメモリを詰める 破棄済みのEntityや重複は無視される
+         * @param pEntities 破棄するEntityの配列
+         * @param count 要素数
+         * @param mode Chunk内の行の詰め方(デフォルトで末尾の行を移動する)
+         */
+        void destroyEntities(const Entity* pEntities, const std::size_t count, RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            // (ChunkのID, 行, Chunk)の組にしてChunk毎にまとめる
+            // アドレスではなくIDで並べるので、Chunkを処理する順序は実行毎に変わらない
+            std::vector<std::tuple<std::size_t, std::size_t, IChunk*>> locations;
+            locations.reserve(count);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (mEntityTable.isAlive(pEntities[i]))
+                {
+                    IChunk* const pChunk = mEntityTable.getChunk(pEntities[i]);
+                    locations.emplace_back(pChunk->getID(), mEntityTable.getRow(pEntities[i]), pChunk);
+                }
+            }
+
+            // IDと行が等しければ同じChunkなので、IDと行だけで比べる
+            const auto less = [](const auto& left, const auto& right)
+            {
+                return std::tie(std::get<0>(left), std::get<1>(left)) < std::tie(std::get<0>(right), std::get<1>(right));
+            };
+            const auto equal = [](const auto& left, const auto& right)
+            {
+                return std::get<0>(left) == std::get<0>(right) && std::get<1>(left) == std::get<1>(right);
+            };
+            std::sort(locations.begin(), locations.end(), less);
+            locations.erase(std::unique(locations.begin(), locations.end(), equal), locations.end());
+
+            std::vector<std::size_t> rows;
+            for (auto itr = locations.begin(); itr != locations.end();)
+            {
+                const std::size_t chunkID = std::get<0>(*itr);
+                IChunk* const pChunk      = std::get<2>(*itr);
+
+                rows.clear();
+                for (; itr != locations.end() && std::get<0>(*itr) == chunkID; ++itr)
+                {
+                    rows.emplace_back(std::get<1>(*itr));
+                }
+
+                pChunk->deallocate(rows, mode);
+            }
+        }
+
+        /**
+         * @brief 複数のEntityをまとめて破棄する
+         *
+         * @param entities 破棄するEntityたち
+         * @param mode Chunk内の行の詰め方(デフォルトで末尾の行を移動する)
+         */
+        void destroyEntities(const std::vector<Entity>& entities, RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            destroyEntities(entities.data(), entities.size(), mode);
+        }
+
+        /**
+         * @brief Entityがまだ生存しているかどうか判定する
+         *
+         * @param entity 判定するEntity
+         * @return true 生存している
+         * @return false 破棄済み
+         */
+        bool isAlive(const Entity& entity) const
+        {
+            return mEntityTable.isAlive(entity);
+        }
+
+        /**
+         * @brief ChunkとEntityTableのメモリを確保するリソースを取得する
+         *
+         * @return std::pmr::memory_resource*
+         */
+        std::pmr::memory_resource* getMemoryResource() const
+        {
+            return mpMemoryResource;
+        }
+
+        /**
+         * @brief 現在の変更バージョンを取得する(Systemを1つ実行する毎に増える)
+         * @details IChunk::isChangedSinceに渡せば、取得した時点以降に変更された列かどうかを判定できる
+         * @return std::uint64_t 変更バージョン
+         */
+        std::uint64_t getChangeVersion() const
+        {
+            return mChangeVersion;
+        }
+
+        /**
+         * @brief Entityが指定したComponentData型を持つかどうか判定する
+         *
+         * @tparam T ComponentDataの型
+         * @param entity 生存しているEntity
+         * @return true 持つ
+         * @return false 持たない
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        bool hasComponentData(const Entity& entity) const
+        {
+            return mEntityTable.getChunk(entity)->getArchetype().template isIn<T>();
+        }
+
+        /**
+         * @brief 呼び出したスレッド用のCommandBufferを取得する
+         * @details forEach中やforEachParallelのスレッド内ではEntityの構築・破棄を直接行わず、これに記録する
+         *          記録は各Systemの更新後(もしくはflushCommandBuffers)にまとめて反映される
+         *          返した参照は反映後も有効で、endを呼ぶまで同じスレッドには同じCommandBufferを返す
+         * @return CommandBuffer<Key, Common>& このスレッド専用のCommandBuffer
+         */
+        CommandBuffer<Key, Common>& getCommandBuffer()
+        {
+            std::lock_guard<std::mutex> lock(mCommandBufferMutex);
+
+            auto& pCommandBuffer = mCommandBuffers[std::this_thread::get_id()];
+            if (!pCommandBuffer)
+            {
+                pCommandBuffer = std::make_unique<CommandBuffer<Key, Common>>();
+            }
+
+            return *pCommandBuffer;
+        }
+
+        /**
+         * @brief 全てのCommandBufferの記録を反映する
+         * @details 書き込み、破棄(全CommandBuffer分をChunk毎にまとめて1回)、構築(Archetype毎にまとめて)の順に実行する
+         * @warning forEach中や並列実行中に呼ばないこと
+         */
+        void flushCommandBuffers()
+        {
+            std::lock_guard<std::mutex> lock(mCommandBufferMutex);
+
+            // CommandBufferは破棄せずに空にして使い回す(getCommandBufferで得た参照をSystemが保持していてもよいように)
+            const bool recorded = std::any_of(mCommandBuffers.begin(), mCommandBuffers.end(), [](const auto& pair)
+                                              { return !pair.second->empty(); });
+            if (!recorded)
+            {
+                return;
+            }
+
+            for (auto& [id, pCommandBuffer] : mCommandBuffers)
+            {
+                pCommandBuffer->playbackWrites(*this);
+            }
+
+            mDestroyedByCommand.clear();
+            for (auto& [id, pCommandBuffer] : mCommandBuffers)
+            {
+                pCommandBuffer->appendDestroyed(mDestroyedByCommand);
+            }
+            destroyEntities(mDestroyedByCommand);
+
+            for (auto& [id, pCommandBuffer] : mCommandBuffers)
+            {
+                pCommandBuffer->playbackCreates(*this);
+                pCommandBuffer->clear();
+            }
         }
 
         /**
@@ -99,9 +424,7 @@ namespace mvecs
         template <typename T>
         void setComponentData(const Entity& entity, const T& value)
         {
-            //const auto index = findChunk(entity.getChunkID());
-            return mpChunks[findChunk(entity.getChunkID())]->template getComponentData<T>(entity) = value;
-            // mpChunks.find(entity.getChunkID())->second.setComponentData<T>(entity, value);
+            mEntityTable.getChunk(entity)->template getComponentData<T>(mEntityTable.getRow(entity)) = value;
         }
 
         /**
@@ -114,9 +437,48 @@ namespace mvecs
         template <typename T>
         T& getComponentData(const Entity& entity)
         {
-            //const auto index = findChunk(entity.getChunkID());
-            return mpChunks[findChunk(entity.getChunkID())].template getComponentData<T>(entity);
-            // return mpChunks.find(entity.getChunkID())->second.getComponentData<T>(entity);
+            return mEntityTable.getChunk(entity)->template getComponentData<T>(mEntityTable.getRow(entity));
+        }
+
+        /**
+         * @brief EntityにComponentDataを追加する
+         * @details Entityの行を追加後のArchetypeのChunkに列毎に移動する(Entityはそのまま使える)
+         *          移動先のChunkはArchetype毎にキャッシュされるため、2回目以降はArchetypeの検索を行わない
+         * @warning forEach中や並列実行中に呼ばないこと
+         * @tparam T 追加するComponentDataの型
+         * @param entity 追加先Entity(まだTを持たないこと)
+         * @param value 追加するComponentDataの値
+         * @param mode 移動元のChunk内の行の詰め方
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        void addComponentData(const Entity& entity, const T& value = T(), RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            assert(!hasComponentData<T>(entity) || !"this entity already has the component data!");
+
+            IChunk* const pChunk = mEntityTable.getChunk(entity);
+            pChunk->moveTo(entity, *getTransitionChunk(pChunk, TypeInfo::create<T>(), true), mode);
+
+            getComponentData<T>(entity) = value;
+        }
+
+        /**
+         * @brief EntityからComponentDataを削除する
+         * @details Entityの行を削除後のArchetypeのChunkに列毎に移動する(Entityはそのまま使える)
+         *          移動先のChunkはArchetype毎にキャッシュされるため、2回目以降はArchetypeの検索を行わない
+         * @warning forEach中や並列実行中に呼ばないこと 全てのComponentDataを削除することはできない(destroyEntityを使う)
+         * @tparam T 削除するComponentDataの型
+         * @param entity 削除先Entity(Tを持つこと)
+         * @param mode 移動元のChunk内の行の詰め方
+         */
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        void removeComponentData(const Entity& entity, RemovalMode mode = RemovalMode::SwapAndPop)
+        {
+            assert(hasComponentData<T>(entity) || !"this entity does not have the component data!");
+
+            IChunk* const pChunk = mEntityTable.getChunk(entity);
+            assert(pChunk->getArchetype().getTypeCount() > 1 || !"can not remove the last component data!");
+
+            pChunk->moveTo(entity, *getTransitionChunk(pChunk, TypeInfo::create<T>(), false), mode);
         }
 
         /**
@@ -159,79 +521,194 @@ namespace mvecs
         //}
 
         /**
-         * @brief 複数のComponentData型に対するforEach
-         * @warning 指定したComponentData型をすべて含むChunk(Entity)しか巡回されない
-         * @tparam Args
-         * @param func
+         * @brief 条件に一致するChunkの一覧(Query)を取得する
+         * @details Queryは条件毎にWorldにキャッシュされ、以降はChunkが構築された時にのみ更新される
+         *          そのため同じ条件で何度呼んでも全Chunkの一致判定は最初の1回しか行わない
+         * @tparam Args 条件(ComponentData型とWithは持つ、Withoutは持たない、Optionalは問わない)
+         * @return const Query& 条件に一致するChunkの一覧
          */
         template <typename... Args>
-        void forEach(const std::function<void(Args&...)>& func)
+        const Query& query()
         {
-            assert(sizeof...(Args) != 0 || !"empty type to forEach!");
+            static_assert(sizeof...(Args) != 0, "empty type to query!");
 
-            constexpr Archetype targetArchetype = Archetype::create<Args...>();
+            static const QueryKey key = QueryKey::create<Args...>();
+            if (auto itr = mQueries.find(key); itr != mQueries.end())
+            {
+                return itr->second;
+            }
 
+            // 初回のみ既存のChunkから一致するものを集める
+            Query& query = mQueries.emplace(key, Query(key)).first->second;
             for (auto& pChunk : mpChunks)
             {
-                auto entityNum = pChunk->getEntityNum();
-                if (pChunk->getArchetype().isIn(targetArchetype) && entityNum > 0)
+                query.tryAddChunk(pChunk.get());
+            }
+
+            return query;
+        }
+
+        /**
+         * @brief 複数のComponentData型に対するforEach
+         * @details Optional<T>はTを持たないChunkではnullptrが、持つChunkではそのアドレスが渡される
+         *          Argsに含めたEntityにはその行のEntityがChunkのEntityの列から渡される(自身のEntityをComponentDataに持たせる必要はない)
+         *          filtersにWith<T>(持つが読み書きしない)・Without<T>(持たない)を渡すと巡回するChunkを絞り込める
+         *          条件はChunkの構築時に判定されるため、除外されたChunkは巡回中に一切読まれない
+         *          Changed<T>を渡すと、実行中のSystemの前回の実行以降にTの列が変更されたChunkのみを巡回する(System外では全て)
+         *          const Tとして渡した型は読むだけとみなし、列の変更バージョンを更新しない
+         * @warning 指定したComponentData型をすべて含むChunk(Entity)しか巡回されない
+         * @tparam Args 読み書きする型(ComponentData型、Optional、Entity)
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数(ComponentData型はT&、Optional<T>はT*、EntityはEntityを受け取る)
+         * @param ... 絞り込みの条件(型のみ使う)
+         */
+        template <typename... Args, typename... Filters>
+        void forEach(const std::function<void(typename QueryTerm<Args>::Param...)>& func, Filters...)
+        {
+            static_assert(sizeof...(Args) != 0, "empty type to forEach!");
+
+            forEachImpl<Args...>(func, Filters()...);
+        }
+
+        /**
+         * @brief 関数オブジェクトの引数の型から読み書きする型を求めるforEach
+         * @details 引数がT&(const T&)ならComponentData型T(const T)、T*(const T*)ならOptional<T>(Optional<const T>)として扱う
+         *          Entity(const Entity&)を受け取る引数にはその行のEntityが渡される([](Entity e, Pos& pos){...}など)
+         *          const T&・const T*は読むだけなので列の変更バージョンを更新しない
+         *          std::functionを介さずに呼び出すため、関数呼び出しがインライン展開できる
+         * @tparam Func 関数オブジェクトの型(operator()がテンプレートでないもの)
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数オブジェクト
+         * @param ... 絞り込みの条件(型のみ使う)
+         */
+        template <typename Func, typename... Filters, typename = typename CallableTraits<std::decay_t<Func>>::Terms>
+        void forEach(Func&& func, Filters...)
+        {
+            forEachDeduced(func, static_cast<typename CallableTraits<std::decay_t<Func>>::Terms*>(nullptr), Filters()...);
+        }
+
+        /**
+         * @brief 条件に一致するChunk毎に1回、各ComponentData型の配列をまとめて渡すforEach
+         * @details funcは(std::size_t entityNum, const Entity* pEntities, ComponentArray<Args>&... arrays)で呼ばれる
+         *          pEntities[i]はarraysのi番目の行のEntity 行毎の呼び出しが無いため、配列を直接扱うカーネル(SIMDなど)を書ける
+         *          異なる型の配列は互いに重ならないため、取り出したポインタにはMVECS_RESTRICTを付けてよい
+         *          restrictは関数の戻り値に付けても呼び出し側に伝わらないため、funcの中でポインタを受け取る変数に付けること
+         *          (例: Position* MVECS_RESTRICT pPos = positions.getBlock(b);)
+         *          AoSoAの場合、配列はブロック毎にしか連続していない(ComponentArray::getBlockで取得する)
+         * @warning funcの中でEntityの構築・破棄、ComponentDataの追加・削除を行わないこと(CommandBufferを使う)
+         * @tparam Args 読み書きするComponentData型
+         * @tparam Func 関数オブジェクトの型
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数オブジェクト
+         * @param ... 絞り込みの条件(型のみ使う)
+         */
+        template <typename... Args, typename Func, typename... Filters>
+        void forEachChunk(Func&& func, Filters...)
+        {
+            static_assert(sizeof...(Args) != 0, "empty type to forEachChunk!");
+            static_assert((IsComponentDataType<Args> && ...), "forEachChunk only accepts ComponentData types (use filters for With and Without)!");
+            static_assert((!QueryTerm<Filters>::IsRead && ...), "filters must be With, Without or Changed!");
+
+            for (IChunk* pChunk : query<Args..., Filters...>().getChunks())
+            {
+                const std::size_t entityNum = pChunk->getEntityNum();
+                if (entityNum == 0 || !(QueryTerm<Filters>::accepts(*pChunk, mLastRunVersion) && ...))
                 {
-                    assert(entityNum);
-                    auto&& tuple = std::make_tuple(pChunk->getComponentArray<Args>()...);
-                    for (std::size_t i = 0; i < entityNum; ++i)
-                    {
-                        func(std::get<ComponentArray<Args>>(tuple)[i]...);
-                    }
+                    continue;
                 }
+
+                auto&& arrays = std::make_tuple(pChunk->getComponentArray<Args>()...);
+                std::apply(
+                    [&](auto&... arrays)
+                    {
+                        func(entityNum, pChunk->getEntities(), arrays...);
+                    },
+                    arrays);
             }
         }
 
         /**
          * @brief forEachを並列実行する
+         * @details Applicationが持つ常駐ワーカー(ThreadPool)で実行するため、呼ぶ度にスレッドを構築しない
+         *          条件に一致する全Chunkを行の範囲(タスク)に分け、ThreadPool::runTasksでスレッド毎のキューに配る
+         *          1タスクの行数はsetParallelBatchSizeで設定した値以上で、小さいChunkは分割されない
+         *          行毎の処理の重さが偏っても、空いたスレッドが他のスレッドの残りのタスクを盗んで実行する
+         *          funcが例外を投げた場合、残りのタスクは実行されず、最初の例外が呼び出し元のスレッドで投げ直される
          * @warning funcはthread-safeであること
          *
          * @tparam T 実行するComponentData型
-         * @tparam ThreadNum スレッド数(デフォルトで4)
          * @tparam typename ComponentData型判定
          * @param func
+         * @param threadNum 使うスレッド数(0の場合はThreadPoolの全スレッド、それより多くは使えない)
          */
-        template <typename T, std::size_t ThreadNum = 4, typename = std::enable_if_t<IsComponentDataType<T>>>
-        void forEachParallel(const std::function<void(T&)>& func)
+        template <typename T, typename = std::enable_if_t<IsComponentDataType<T>>>
+        void forEachParallel(const std::function<void(T&)>& func, const std::size_t threadNum = 0)
         {
+            ThreadPool& threadPool = mpApplication->getThreadPool();
+            const std::size_t usedNum = threadNum == 0 ? threadPool.getThreadNum() : std::min(threadNum, threadPool.getThreadNum());
+
             // ComponentArray作成
+            const Query& matched = query<T>();
             std::vector<ComponentArray<T>> componentArrays;
-            const auto&& reserveSize = mpChunks.size() / 4;
-            componentArrays.reserve(reserveSize < 1 ? 1 : reserveSize);
-            for (auto& pChunk : mpChunks)
+            componentArrays.reserve(matched.getChunks().size());
+            for (IChunk* pChunk : matched.getChunks())
             {
-                if (pChunk->getArchetype().isIn<T>())
+                if (pChunk->getEntityNum() != 0)
                 {
                     componentArrays.emplace_back(pChunk->getComponentArray<T>());
                 }
             }
 
-            // 実行
-            std::array<std::thread, ThreadNum> threads;
-            for (uint8_t i = 0; i < ThreadNum; ++i)
-            {
-                threads[i] = std::thread(
-                    [i, &componentArrays, &func]()
-                    {
-                        std::size_t start = 0, end = 0;
-                        for (auto& componentArray : componentArrays)
-                        {
-                            start = i * componentArray.size() / ThreadNum;
-                            end   = (i + 1) * componentArray.size() / ThreadNum;
-                            for (std::size_t j = start; j < end; ++j)
-                                func(componentArray[j]);
-                        }
-                    });
-            }
+            // 盗む余地を残すため1スレッドあたりParallelTaskNumPerThread個程度に分けるが、1タスクはmParallelBatchSize行以上にする
+            const std::size_t entityNum = matched.getEntityNum();
+            const std::size_t taskNumHint = usedNum * ParallelTaskNumPerThread;
+            const std::size_t batchSize = std::max(mParallelBatchSize, (entityNum + taskNumHint - 1) / taskNumHint);
 
-            for (auto& thread : threads)
+            // タスク(配列の添字, 先頭の行, 末尾の行)
+            // タスクはThreadPoolの排他の外で作るので、複数のスレッドから同時に呼ばれても壊れないようにメンバには持たない
+            std::vector<ParallelTask> tasks;
+            tasks.reserve(entityNum / batchSize + componentArrays.size());
+            for (std::size_t i = 0; i < componentArrays.size(); ++i)
             {
-                thread.join();
+                const std::size_t size = componentArrays[i].size();
+                for (std::size_t begin = 0; begin < size; begin += batchSize)
+                {
+                    tasks.push_back(ParallelTask{i, begin, std::min(begin + batchSize, size)});
+                }
             }
+
+            // 実行
+            threadPool.runTasks(
+                tasks.size(),
+                [&tasks, &componentArrays, &func](const std::size_t taskIndex)
+                {
+                    const ParallelTask& task = tasks[taskIndex];
+                    auto& componentArray     = componentArrays[task.arrayIndex];
+                    for (std::size_t j = task.begin; j < task.end; ++j)
+                        func(componentArray[j]);
+                },
+                usedNum);
+        }
+
+        /**
+         * @brief forEachParallelで1タスクに割り当てる最小の行数を設定する
+         * @details 小さくすると偏りを均しやすくなるが、タスクを取り出す回数が増える
+         * @param batchSize 行数(1以上)
+         */
+        void setParallelBatchSize(const std::size_t batchSize)
+        {
+            assert(batchSize != 0 || !"batch size must not be 0!");
+            mParallelBatchSize = batchSize;
+        }
+
+        /**
+         * @brief forEachParallelで1タスクに割り当てる最小の行数を取得する
+         *
+         * @return std::size_t 行数
+         */
+        std::size_t getParallelBatchSize() const
+        {
+            return mParallelBatchSize;
         }
 
         /**
@@ -254,18 +731,31 @@ namespace mvecs
          */
         void update()
         {
-            for (auto itr = mSystems.begin(); itr != mSystems.end(); ++itr)
+            for (auto itr = mSystems.begin(); itr != mSystems.end();)
             {
+                // Changed<T>はこのSystemの前回の実行以降の変更のみを見る
+                mLastRunVersion = (*itr)->mLastRunVersion;
+
                 // system.second->onUpdate();
                 (*itr)->onUpdate();
 
+                // Systemの実行中に記録された構造変更をここで反映する
+                flushCommandBuffers();
+
+                // このSystemの書き込みは次の実行では見えず、以降のSystemには見えるようにする
+                (*itr)->mLastRunVersion = mChangeVersion++;
+
                 if ((*itr)->removeThis())
                 {
-                    mSystems.erase(itr);
+                    itr = mSystems.erase(itr);
                     continue;
                 }
+
+                ++itr;
             }
 
+            mLastRunVersion = 0;
+
             // std::cout << "debug--------\n";
             // for (const auto& chunk : mpChunks)
             // {
@@ -288,6 +778,11 @@ namespace mvecs
                 system->onEnd();
             }
 
+            {
+                std::lock_guard<std::mutex> lock(mCommandBufferMutex);
+                mCommandBuffers.clear();
+            }
+
             for (auto& pChunk : mpChunks)
             {
                 pChunk->destroy();
@@ -324,7 +819,292 @@ namespace mvecs
             return mpApplication->common();
         }
 
+        //! ページの場合のデフォルトの1ページのバイト数
+        static constexpr std::size_t DefaultPageSize = 16 * 1024;
+        //! forEachParallelのデフォルトの1タスクあたりの最小の行数
+        static constexpr std::size_t DefaultParallelBatchSize = 1024;
+        //! forEachParallelで1スレッドあたりに作るタスク数の目安(盗む余地を残すため)
+        static constexpr std::size_t ParallelTaskNumPerThread = 8;
+
     private:
+        /**
+         * @brief forEachParallelのタスク(1つのComponentArrayの行の範囲)
+         *
+         */
+        struct ParallelTask
+        {
+            //! ComponentArrayの添字
+            std::size_t arrayIndex;
+            //! 先頭の行
+            std::size_t begin;
+            //! 末尾の行(含まない)
+            std::size_t end;
+        };
+
+        /**
+         * @brief Archetype毎の設定
+         *
+         */
+        struct ArchetypeSettings
+        {
+            //! 保持の仕方
+            StorageMode storageMode = StorageMode::Contiguous;
+            //! ページの場合の1ページのバイト数
+            std::size_t pageSize = DefaultPageSize;
+            //! 連続領域の場合の容量の伸ばし方・切り詰め方
+            CapacityPolicy capacityPolicy;
+            //! 列の並べ方
+            ColumnLayout columnLayout = ColumnLayout::SoA;
+            //! AoSoAの場合の1ブロックあたりのEntity数
+            std::size_t blockEntityNum = IChunk::DefaultBlockEntityNum;
+        };
+
+        /**
+         * @brief Archetype毎の設定とChunkたち
+         *
+         */
+        struct ArchetypeRecord
+        {
+            //! 設定
+            ArchetypeSettings settings;
+            //! このArchetypeのChunkたち(ページの場合は構築した順)
+            std::vector<IChunk*> pChunks;
+            //! 最後にEntityを確保できたChunkの添字(ページの場合に満杯でないページを探す起点)
+            std::size_t allocatableIndex = 0;
+        };
+
+        /**
+         * @brief Archetypeの設定とChunkたちを取得する(無ければデフォルトで追加する)
+         * @details ComponentSignatureをキーにしたハッシュテーブルを引くため、Archetypeの数に依らない
+         * @param archetype
+         * @return ArchetypeRecord&
+         */
+        ArchetypeRecord& getArchetypeRecord(const Archetype& archetype)
+        {
+            return mArchetypeRecords[archetype.getSignature()];
+        }
+
+        /**
+         * @brief 指定したComponentData型のChunkを取得する(無ければ構築する)
+         * @details ページの場合は空きのあるページを返し、全て満杯なら新しいページを追加する
+         * @tparam Args ComponentData型
+         * @param reserveSizeIfCreatedNewChunk Chunkが新しく構築される場合に確保する容量(ページの場合は無視される)
+         * @return IChunk* 対応するChunk
+         */
+        template <typename... Args>
+        IChunk* getOrCreateChunk(const std::size_t reserveSizeIfCreatedNewChunk)
+        {
+            const Archetype& archetype = Archetype::get<Args...>();
+
+            if (IChunk* const pChunk = findAllocatableChunk(archetype))
+            {
+                return pChunk;
+            }
+
+            return createChunk<Args...>(reserveSizeIfCreatedNewChunk);
+        }
+
+        /**
+         * @brief Archetypeに対応するChunkを取得する(無ければ構築する、実行時に組み立てたArchetype用)
+         *
+         * @param archetype Archetype
+         * @param reserveSizeIfCreatedNewChunk Chunkが新しく構築される場合に確保する容量(ページの場合は無視される)
+         * @return IChunk* 対応するChunk
+         */
+        IChunk* getOrCreateChunk(const Archetype& archetype, const std::size_t reserveSizeIfCreatedNewChunk)
+        {
+            if (IChunk* const pChunk = findAllocatableChunk(archetype))
+            {
+                return pChunk;
+            }
+
+            return createChunkImpl<Chunk<>>(archetype, reserveSizeIfCreatedNewChunk);
+        }
+
+        /**
+         * @brief Archetypeに対応する、Entityを確保できるChunkを探す
+         *
+         * @param archetype Archetype
+         * @return IChunk* 見つかったChunk(無ければnullptr)
+         */
+        IChunk* findAllocatableChunk(const Archetype& archetype)
+        {
+            ArchetypeRecord& record = getArchetypeRecord(archetype);
+
+            // 連続領域の場合は常に先頭(唯一)のChunk、ページの場合は前回のページが空いていればそれを使う
+            if (record.allocatableIndex < record.pChunks.size() && !record.pChunks[record.allocatableIndex]->isFull())
+            {
+                return record.pChunks[record.allocatableIndex];
+            }
+
+            for (std::size_t i = 0; i < record.pChunks.size(); ++i)
+            {
+                if (!record.pChunks[i]->isFull())
+                {
+                    record.allocatableIndex = i;
+                    return record.pChunks[i];
+                }
+            }
+
+            return nullptr;
+        }
+
+        /**
+         * @brief ComponentData型を追加・削除した時の移動先Chunkを取得する
+         * @details 移動元Chunkのキャッシュを使い、無い場合(ページの場合は満杯の場合も)のみ探して構築する
+         * @param pChunk 移動元Chunk
+         * @param type 追加・削除するComponentData型
+         * @param added 追加ならtrue、削除ならfalse
+         * @return IChunk* 移動先Chunk
+         */
+        IChunk* getTransitionChunk(IChunk* pChunk, const TypeInfo& type, const bool added)
+        {
+            IChunk*& pTarget = pChunk->getTransition(type.getHash(), added);
+            if (!pTarget || pTarget->isFull())
+            {
+                const Archetype& archetype = pChunk->getArchetype();
+                pTarget = getOrCreateChunk(added ? archetype.added(type) : archetype.removed(type.getHash()), 1);
+            }
+
+            return pTarget;
+        }
+
+        /**
+         * @brief 指定したComponentData型のChunk(ページの場合は新しいページ)を構築する
+         *
+         * @tparam Args ComponentData型
+         * @param reserveSize 確保する容量(ページの場合は無視される)
+         * @return IChunk* 構築したChunk
+         */
+        template <typename... Args>
+        IChunk* createChunk(const std::size_t reserveSize)
+        {
+            return createChunkImpl<Chunk<Args...>>(Archetype::get<Args...>(), reserveSize);
+        }
+
+        /**
+         * @brief ArchetypeのChunk(ページの場合は新しいページ)を構築する実装部
+         *
+         * @tparam ChunkType 構築するChunkの型
+         * @param archetype Archetype
+         * @param reserveSize 確保する容量(ページの場合は無視される)
+         * @return IChunk* 構築したChunk
+         */
+        template <typename ChunkType>
+        IChunk* createChunkImpl(const Archetype& archetype, const std::size_t reserveSize)
+        {
+            ArchetypeRecord& record = getArchetypeRecord(archetype);
+            const ArchetypeSettings& settings = record.settings;
+
+            IChunk* p = nullptr;
+            if (settings.storageMode == StorageMode::Paged)
+            {
+                std::size_t pageEntityNum = 0;
+                if (settings.columnLayout == ColumnLayout::AoSoA)
+                {
+                    // ページに収まる最大のブロック数
+                    pageEntityNum = std::max<std::size_t>(settings.pageSize / archetype.getBlockStride(settings.blockEntityNum), 1) * settings.blockEntityNum;
+                }
+                else
+                {
+                    // 列の間の詰め物も含めてページに収まる最大のEntity数
+                    pageEntityNum = std::max<std::size_t>(settings.pageSize / archetype.getAllTypeSize(), 1);
+                    while (pageEntityNum > 1 && archetype.getMemorySize(pageEntityNum) > settings.pageSize)
+                    {
+                        --pageEntityNum;
+                    }
+                }
+
+                p = new ChunkType(ChunkType::create(genChunkID(), archetype, &mEntityTable, mpMemoryResource, pageEntityNum, StorageMode::Paged, settings.columnLayout, settings.blockEntityNum));
+            }
+            else
+            {
+                p = new ChunkType(ChunkType::create(genChunkID(), archetype, &mEntityTable, mpMemoryResource, std::max<std::size_t>(reserveSize, 1), StorageMode::Contiguous, settings.columnLayout, settings.blockEntityNum));
+            }
+
+            p->setCapacityPolicy(settings.capacityPolicy);
+            p->setChangeVersionSource(&mChangeVersion);
+
+            record.pChunks.emplace_back(p);
+            record.allocatableIndex = record.pChunks.size() - 1;
+
+            // キャッシュしているQueryに一致すれば追加する(Queryの更新はChunkの構築時のみ)
+            for (auto& [required, query] : mQueries)
+            {
+                query.tryAddChunk(p);
+            }
+
+            return insertChunk(p).get();
+        }
+
+        /**
+         * @brief forEachの実装部(Chunk毎に配列を取得し、連続しているブロック毎にポインタで辿る)
+         *
+         * @tparam Args 読み書きする型(ComponentData型、Optional、Entity)
+         * @tparam Func 関数オブジェクトの型
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数オブジェクト
+         * @param ... 絞り込みの条件(型のみ使う)
+         */
+        template <typename... Args, typename Func, typename... Filters>
+        void forEachImpl(Func& func, Filters...)
+        {
+            static_assert((QueryTerm<Args>::IsRead && ...), "With, Without and Changed must be passed as filters!");
+            static_assert((!QueryTerm<Filters>::IsRead && ...), "filters must be With, Without or Changed!");
+
+            for (IChunk* pChunk : query<Args..., Filters...>().getChunks())
+            {
+                // 変更の判定は配列を取得する(変更バージョンを更新する)前に行う
+                const std::size_t entityNum = pChunk->getEntityNum();
+                if (entityNum == 0 || !(QueryTerm<Filters>::accepts(*pChunk, mLastRunVersion) && ...))
+                {
+                    continue;
+                }
+
+                // 連続しているブロック毎にポインタで辿る(SoAの場合は1ブロック)
+                const std::size_t blockEntityNum = pChunk->getColumnLayout() == ColumnLayout::AoSoA ? pChunk->getBlockEntityNum() : entityNum;
+                auto&& arrays                    = std::make_tuple(QueryTerm<Args>::getArray(*pChunk)...);
+                std::apply(
+                    [&](auto&... arrays)
+                    {
+                        for (std::size_t block = 0; block * blockEntityNum < entityNum; ++block)
+                        {
+                            const std::size_t blockSize = std::min(blockEntityNum, entityNum - block * blockEntityNum);
+                            auto&& pointers             = std::make_tuple(QueryTerm<Args>::getBlock(arrays, block)...);
+                            // 各型のブロック(とEntityの列)は互いに重ならないので、別名を考慮しなくてよいことをコンパイラに伝える
+                            std::apply(
+                                [&](auto* MVECS_RESTRICT... pBlocks)
+                                {
+                                    for (std::size_t i = 0; i < blockSize; ++i)
+                                    {
+                                        func(QueryTerm<Args>::get(pBlocks, i)...);
+                                    }
+                                },
+                                pointers);
+                        }
+                    },
+                    arrays);
+            }
+        }
+
+        /**
+         * @brief 関数オブジェクトの引数から求めた型の並びでforEachImplを呼ぶ
+         *
+         * @tparam Func 関数オブジェクトの型
+         * @tparam Args 読み書きする型(ComponentData型、Optional、Entity)
+         * @tparam Filters With、Without、Changed
+         * @param func 実行する関数オブジェクト
+         * @param ... 型の並び(std::tuple)を渡すためのポインタ(値は使わない)
+         * @param filters 絞り込みの条件
+         */
+        template <typename Func, typename... Args, typename... Filters>
+        void forEachDeduced(Func& func, std::tuple<Args...>*, Filters... filters)
+        {
+            static_assert(sizeof...(Args) != 0, "empty type to forEach!");
+
+            forEachImpl<Args...>(func, filters...);
+        }
+
         /**
          * @brief ChunkのIDを生成する
          *
@@ -449,12 +1229,39 @@ namespace mvecs
         //! Applicationのポインタ
         Application<Key, Common>* mpApplication;
 
-        //! Chunkたち
+        //! ChunkとEntityTableのメモリを確保するリソース
+        std::pmr::memory_resource* mpMemoryResource;
+
+        //! Entityの位置を保持するスロットテーブル(Chunkより先に構築し、後に破棄する)
+        EntityTable mEntityTable;
+
+        //! Chunkたち(ページの場合は1ページが1つのChunk)
         std::vector<std::unique_ptr<IChunk>> mpChunks;
 
+        //! Archetype毎の設定とChunkたち(ComponentSignature -> ArchetypeRecord)
+        std::unordered_map<ComponentSignature, ArchetypeRecord> mArchetypeRecords;
+
+        //! キャッシュしたQuery(条件 -> Query)
+        std::unordered_map<QueryKey, Query> mQueries;
+
         //! Systemたち
         std::list<std::unique_ptr<ISystem<Key, Common>>> mSystems;
 
+        //! スレッド毎のCommandBuffer
+        std::unordered_map<std::thread::id, std::unique_ptr<CommandBuffer<Key, Common>>> mCommandBuffers;
+        //! mCommandBuffersの排他制御(取得時のみ使い、記録中はロックしない)
+        std::mutex mCommandBufferMutex;
+        //! CommandBufferで破棄するEntityをまとめる作業領域
+        std::vector<Entity> mDestroyedByCommand;
+
+        //! 変更バージョン(Systemを1つ実行する毎に増える、列に書き込み可能な形で渡した時点の値がChunkに記録される)
+        std::uint64_t mChangeVersion;
+        //! 実行中のSystemの前回の実行時の変更バージョン(Changed<T>の判定に使う、System外では0)
+        std::uint64_t mLastRunVersion;
+
+        //! forEachParallelで1タスクに割り当てる最小の行数
+        std::size_t mParallelBatchSize;
+
         //! すでにinitされたかどうか これによってSystem追加時にinitするかどうか決まる
         bool mIsRunning;
     };
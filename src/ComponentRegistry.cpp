@@ -0,0 +1,83 @@
+#include "../include/MVECS/ComponentRegistry.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+namespace mvecs
+{
+    namespace
+    {
+        //! 型のハッシュ値 -> ID
+        std::unordered_map<std::uint32_t, std::uint32_t>& getIDTable()
+        {
+            static std::unordered_map<std::uint32_t, std::uint32_t> table;
+            return table;
+        }
+
+        //! ID -> 型情報(要素のアドレスは変わらない)
+        std::array<TypeInfo, ComponentRegistry::MaxComponentTypeNum>& getTypeInfoTable()
+        {
+            static std::array<TypeInfo, ComponentRegistry::MaxComponentTypeNum> table;
+            return table;
+        }
+
+        //! getIDTable, getTypeInfoTableの保護
+        std::mutex& getIDTableMutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+    }  // namespace
+
+    std::uint32_t ComponentRegistry::registerType(const TypeInfo& type)
+    {
+        std::lock_guard<std::mutex> lock(getIDTableMutex());
+
+        auto& table = getIDTable();
+        if (const auto itr = table.find(type.getHash()); itr != table.end())
+        {
+            return itr->second;
+        }
+
+        // 上限を超えるとComponentSignatureと型情報の表の範囲外に書き込むため、リリースビルドでも止める
+        if (table.size() >= MaxComponentTypeNum)
+        {
+            std::cerr << "[MVECS] too many ComponentData types (max " << MaxComponentTypeNum << ")!\n";
+            std::abort();
+        }
+
+        const std::uint32_t id = static_cast<std::uint32_t>(table.size());
+        table.emplace(type.getHash(), id);
+        getTypeInfoTable()[id] = type;
+
+        return id;
+    }
+
+    std::uint32_t ComponentRegistry::getID(const std::uint32_t typeHash)
+    {
+        std::lock_guard<std::mutex> lock(getIDTableMutex());
+
+        const auto& table = getIDTable();
+        const auto itr = table.find(typeHash);
+
+        return itr != table.end() ? itr->second : InvalidID;
+    }
+
+    const TypeInfo& ComponentRegistry::getTypeInfo(const std::uint32_t id)
+    {
+        assert(id < getRegisteredNum() || !"the type is not registered!");
+
+        return getTypeInfoTable()[id];
+    }
+
+    std::size_t ComponentRegistry::getRegisteredNum()
+    {
+        std::lock_guard<std::mutex> lock(getIDTableMutex());
+
+        return getIDTable().size();
+    }
+}  // namespace mvecs
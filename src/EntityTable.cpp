@@ -0,0 +1,64 @@
+#include "../include/MVECS/EntityTable.hpp"
+
+#include <limits>
+
+namespace mvecs
+{
+    EntityTable::EntityTable(std::pmr::memory_resource* pMemoryResource)
+        : mSlots(pMemoryResource)
+        , mFreeHead(Entity::InvalidIndex)
+        , mAliveNum(0)
+    {
+    }
+
+    Entity EntityTable::create(IChunk* pChunk, std::size_t row)
+    {
+        assert(pChunk);
+        assert(row <= std::numeric_limits<std::uint32_t>::max());
+
+        std::uint32_t index = mFreeHead;
+        if (index != Entity::InvalidIndex)
+        {
+            // 空きリストから再利用する
+            mFreeHead = mSlots[index].row;
+        }
+        else
+        {
+            assert(mSlots.size() < Entity::InvalidIndex || !"too many entities!");
+            index = static_cast<std::uint32_t>(mSlots.size());
+            mSlots.emplace_back(EntitySlot{nullptr, 0, 0});
+        }
+
+        EntitySlot& slot = mSlots[index];
+        slot.pChunk      = pChunk;
+        slot.row         = static_cast<std::uint32_t>(row);
+
+        ++mAliveNum;
+
+        return Entity(index, slot.generation);
+    }
+
+    void EntityTable::release(const Entity& entity)
+    {
+        assert(isAlive(entity) || !"this entity was already destroyed!");
+
+        EntitySlot& slot = mSlots[entity.getIndex()];
+        slot.pChunk      = nullptr;
+        slot.row         = mFreeHead;
+        // 世代を進めて古いEntityを無効にする
+        ++slot.generation;
+
+        mFreeHead = entity.getIndex();
+        --mAliveNum;
+    }
+
+    void EntityTable::reserve(std::size_t slotNum)
+    {
+        mSlots.reserve(slotNum);
+    }
+
+    std::size_t EntityTable::getAliveNum() const
+    {
+        return mAliveNum;
+    }
+}  // namespace mvecs
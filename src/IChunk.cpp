@@ -1,17 +1,47 @@
 #include "../include/MVECS/IChunk.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 
 namespace mvecs
 {
-	IChunk::IChunk(const std::size_t ID, const Archetype& archetype)
+	IChunk::IChunk(const std::size_t ID, const Archetype& archetype, EntityTable* pEntityTable, std::pmr::memory_resource* pMemoryResource)
 		: mID(ID)
 		, mArchetype(archetype)
 		, mpMemory(nullptr)
-		, mMaxEntityNum(1)
+		, mMaxEntityNum(0)
 		, mEntityNum(0)
+		, mStorageMode(StorageMode::Contiguous)
+		, mPageEntityNum(0)
+		, mColumnLayout(ColumnLayout::SoA)
+		, mBlockEntityNum(0)
+		, mBlockShift(0)
+		, mBlockStride(0)
+		, mReservedEntityNum(0)
+		, mpEntityTable(pEntityTable)
+		, mpChangeVersion(nullptr)
+		, mpMemoryResource(pMemoryResource)
+		, mpResizableMemoryResource(dynamic_cast<ResizableMemoryResource*>(pMemoryResource))
+		, mEntities(pMemoryResource)
 	{
+		assert(mpEntityTable);
+		assert(mpMemoryResource);
+
+		// 型のID -> 列の表を作る(以降の型の検索はこの表を引くだけ)
+		const std::size_t typeCount = mArchetype.getTypeCount();
+		mColumns.resize(typeCount);
+		for (std::size_t i = 0; i < typeCount; ++i)
+		{
+			mColumns[i].typeSize = mArchetype.getTypeSize(i);
+
+			const std::uint32_t id = ComponentRegistry::registerType(mArchetype.getTypeInfo(i));
+			if (id >= mColumnIndexTable.size())
+			{
+				mColumnIndexTable.resize(id + 1, InvalidColumnIndex);
+			}
+			mColumnIndexTable[id] = static_cast<std::uint16_t>(i);
+		}
 	}
 
 	IChunk::~IChunk()
@@ -21,22 +51,71 @@ namespace mvecs
 	IChunk::IChunk(IChunk&& src) noexcept
 		: mID(src.mID)
 		, mArchetype(src.mArchetype)
-		, mpMemory(std::move(src.mpMemory))
+		, mpMemory(src.mpMemory)
+		, mColumns(std::move(src.mColumns))
+		, mColumnIndexTable(std::move(src.mColumnIndexTable))
 		, mMaxEntityNum(src.mMaxEntityNum)
 		, mEntityNum(src.mEntityNum)
+		, mStorageMode(src.mStorageMode)
+		, mPageEntityNum(src.mPageEntityNum)
+		, mColumnLayout(src.mColumnLayout)
+		, mBlockEntityNum(src.mBlockEntityNum)
+		, mBlockShift(src.mBlockShift)
+		, mBlockStride(src.mBlockStride)
+		, mReservedEntityNum(src.mReservedEntityNum)
+		, mCapacityPolicy(src.mCapacityPolicy)
+		, mReallocationStats(src.mReallocationStats)
+		, mpEntityTable(src.mpEntityTable)
+		, mpChangeVersion(src.mpChangeVersion)
+		, mpMemoryResource(src.mpMemoryResource)
+		, mpResizableMemoryResource(src.mpResizableMemoryResource)
+		, mEntities(std::move(src.mEntities))
+		, mAddTransitions(std::move(src.mAddTransitions))
+		, mRemoveTransitions(std::move(src.mRemoveTransitions))
 	{
+		// EntityTableはChunkのアドレスを保持しているため、移動するのは空のChunkのみ
+		assert(mEntityNum == 0 || !"moving non-empty chunk invalidates its entities!");
+
+		src.mpMemory = nullptr;
+		src.mMaxEntityNum = 0;
+		src.mEntityNum = 0;
 	}
 
 	IChunk& IChunk::operator=(IChunk&& src) noexcept
 
 	{
+		assert(src.mEntityNum == 0 || !"moving non-empty chunk invalidates its entities!");
+
+		destroy();
+
 		mID = src.mID;
 		mArchetype = src.mArchetype;
 		mpMemory = src.mpMemory;
+		mColumns = std::move(src.mColumns);
+		mColumnIndexTable = std::move(src.mColumnIndexTable);
 		mMaxEntityNum = src.mMaxEntityNum;
 		mEntityNum = src.mEntityNum;
-
-		src.destroy();
+		mStorageMode = src.mStorageMode;
+		mPageEntityNum = src.mPageEntityNum;
+		mColumnLayout = src.mColumnLayout;
+		mBlockEntityNum = src.mBlockEntityNum;
+		mBlockShift = src.mBlockShift;
+		mBlockStride = src.mBlockStride;
+		mReservedEntityNum = src.mReservedEntityNum;
+		mCapacityPolicy = src.mCapacityPolicy;
+		mReallocationStats = src.mReallocationStats;
+		mpEntityTable = src.mpEntityTable;
+		mpChangeVersion = src.mpChangeVersion;
+		mpMemoryResource = src.mpMemoryResource;
+		mpResizableMemoryResource = src.mpResizableMemoryResource;
+		// mEntitiesのアロケータは伝播しない(リソースが異なる場合は要素がムーブされる)
+		mEntities = std::move(src.mEntities);
+		mAddTransitions = std::move(src.mAddTransitions);
+		mRemoveTransitions = std::move(src.mRemoveTransitions);
+
+		src.mpMemory = nullptr;
+		src.mMaxEntityNum = 0;
+		src.mEntityNum = 0;
 
 		return *this;
 	}
@@ -46,6 +125,21 @@ namespace mvecs
 		return mID;
 	}
 
+	IChunk*& IChunk::getTransition(const std::uint32_t typeHash, const bool added)
+	{
+		auto& transitions = added ? mAddTransitions : mRemoveTransitions;
+
+		for (auto& [hash, pChunk] : transitions)
+		{
+			if (hash == typeHash)
+			{
+				return pChunk;
+			}
+		}
+
+		return transitions.emplace_back(typeHash, nullptr).second;
+	}
+
 	const Archetype& IChunk::getArchetype() const
 	{
 		return mArchetype;
@@ -162,17 +256,14 @@ namespace mvecs
 	void IChunk::clear()
 	{
 		// TODO:どの程度だとパフォーマンスが良いのか(対して変わらないと思う)
-		constexpr std::size_t maxEntityNum = 1;
+		// ページの場合は容量が固定
+		const std::size_t maxEntityNum = getLayoutEntityNum(mStorageMode == StorageMode::Paged ? mPageEntityNum : 1);
 
 		destroy();
 
-		mpMemory = new std::byte[mArchetype.getAllTypeSize() * maxEntityNum]();
+		mpMemory = allocateMemory(maxEntityNum);
 		mMaxEntityNum = maxEntityNum;
-
-		mpEntityIDs.clear();
-
-		mpEntityIDs.emplace_back(new std::size_t(0));
-		mEntityNum = 0;
+		updateColumns();
 	}
 
 	//Entity Chunk::moveTo(const Entity& entity, IChunk& other)
@@ -256,31 +347,236 @@ namespace mvecs
 	//	mMaxEntityNum = newMaxEntityNum;
 	//}
 
+	void IChunk::reserve(const std::size_t entityNum)
+	{
+		assert(mStorageMode == StorageMode::Contiguous || !"paged chunk has fixed capacity!");
+
+		mReservedEntityNum = std::max(mReservedEntityNum, entityNum);
+		if (entityNum > mMaxEntityNum)
+		{
+			reallocate(entityNum);
+		}
+	}
+
+	void IChunk::shrinkToFit()
+	{
+		mReservedEntityNum = 0;
+
+		if (mStorageMode == StorageMode::Paged)
+		{
+			// ページは容量が固定なので、空になったページのメモリだけ解放する(次の確保で割り当て直される)
+			if (mEntityNum == 0 && mpMemory)
+			{
+				destroy();
+			}
+			return;
+		}
+
+		const std::size_t fitEntityNum = getLayoutEntityNum(std::max<std::size_t>(mEntityNum, 1));
+		if (fitEntityNum != mMaxEntityNum)
+		{
+			reallocate(fitEntityNum);
+		}
+	}
+
+	void IChunk::setCapacityPolicy(const CapacityPolicy& policy)
+	{
+		assert(policy.growthFactor > 1.f || !"growth factor must be greater than 1!");
+		assert(policy.shrinkThreshold < 1.f || !"shrink threshold must be less than 1!");
+		mCapacityPolicy = policy;
+
+		// 1以下の係数では切り詰めのループが終わらないため、リリースビルドでも丸める(NaNも弾くため否定で比べる)
+		if (!(mCapacityPolicy.growthFactor >= CapacityPolicy::MinGrowthFactor))
+		{
+			mCapacityPolicy.growthFactor = CapacityPolicy::MinGrowthFactor;
+		}
+		if (!(mCapacityPolicy.shrinkThreshold >= 0.f && mCapacityPolicy.shrinkThreshold < 1.f))
+		{
+			mCapacityPolicy.shrinkThreshold = 0.f;
+		}
+	}
+
+	const CapacityPolicy& IChunk::getCapacityPolicy() const
+	{
+		return mCapacityPolicy;
+	}
+
+	const ReallocationStats& IChunk::getReallocationStats() const
+	{
+		return mReallocationStats;
+	}
+
+	void IChunk::setChangeVersionSource(const std::uint64_t* pChangeVersion)
+	{
+		mpChangeVersion = pChangeVersion;
+	}
+
+	void IChunk::markAllChanged() const
+	{
+		const std::uint64_t version = mpChangeVersion ? *mpChangeVersion : 0;
+		for (const auto& column : mColumns)
+		{
+			column.stamp(version);
+		}
+	}
+
+	ColumnLayout IChunk::getColumnLayout() const
+	{
+		return mColumnLayout;
+	}
+
+	std::size_t IChunk::getBlockEntityNum() const
+	{
+		return mBlockEntityNum;
+	}
+
+	void IChunk::setColumnLayout(const ColumnLayout columnLayout, const std::size_t blockEntityNum)
+	{
+		assert(!mpMemory || !"column layout must be set before allocating memory!");
+
+		mColumnLayout = columnLayout;
+		if (columnLayout == ColumnLayout::SoA)
+		{
+			mBlockEntityNum = 0;
+			mBlockShift = 0;
+			mBlockStride = 0;
+			return;
+		}
+
+		assert((blockEntityNum != 0 && (blockEntityNum & (blockEntityNum - 1)) == 0) || !"block entity num must be a power of 2!");
+
+		mBlockEntityNum = blockEntityNum;
+		mBlockShift = 0;
+		while ((std::size_t(1) << mBlockShift) < blockEntityNum)
+		{
+			++mBlockShift;
+		}
+		mBlockStride = mArchetype.getBlockStride(blockEntityNum);
+	}
+
+	void IChunk::updateColumns()
+	{
+		// AoSoAの場合は先頭のブロック内のオフセット、SoAの場合は全体でのオフセット
+		for (std::size_t i = 0; i < mColumns.size(); ++i)
+		{
+			const std::size_t offset = mColumnLayout == ColumnLayout::AoSoA ? mArchetype.getBlockTypeOffset(i, mBlockEntityNum) : mArchetype.getTypeOffset(i, mMaxEntityNum);
+			mColumns[i].pBase = mpMemory ? mpMemory + offset : nullptr;
+		}
+	}
+
+	std::size_t IChunk::getLayoutEntityNum(const std::size_t maxEntityNum) const
+	{
+		if (mColumnLayout == ColumnLayout::AoSoA)
+		{
+			return (maxEntityNum + mBlockEntityNum - 1) & ~(mBlockEntityNum - 1);
+		}
+
+		return maxEntityNum;
+	}
+
+	std::size_t IChunk::getLayoutMemorySize(const std::size_t maxEntityNum) const
+	{
+		if (mColumnLayout == ColumnLayout::AoSoA)
+		{
+			assert(maxEntityNum % mBlockEntityNum == 0);
+			return (maxEntityNum >> mBlockShift) * mBlockStride;
+		}
+
+		return mArchetype.getMemorySize(maxEntityNum);
+	}
+
 	std::size_t IChunk::getEntityNum() const
 	{
 		return mEntityNum;
 	}
 
+	std::size_t IChunk::getMaxEntityNum() const
+	{
+		return mMaxEntityNum;
+	}
+
+	StorageMode IChunk::getStorageMode() const
+	{
+		return mStorageMode;
+	}
+
+	bool IChunk::isFull() const
+	{
+		return mStorageMode == StorageMode::Paged && mEntityNum >= mPageEntityNum;
+	}
+
+	std::size_t IChunk::getAllocatableEntityNum() const
+	{
+		if (mStorageMode == StorageMode::Paged)
+		{
+			return mPageEntityNum - mEntityNum;
+		}
+
+		return std::numeric_limits<std::size_t>::max();
+	}
+
+	Entity IChunk::getEntity(const std::size_t row) const
+	{
+		assert(row < mEntityNum || !"invalid row!");
+		return mEntities[row];
+	}
+
+	const Entity* IChunk::getEntities() const
+	{
+		return mEntities.data();
+	}
+
+	std::pmr::memory_resource* IChunk::getMemoryResource() const
+	{
+		return mpMemoryResource;
+	}
+
+	std::byte* IChunk::allocateMemory(const std::size_t maxEntityNum) const
+	{
+		const std::size_t memSize = getLayoutMemorySize(maxEntityNum);
+
+		// 各列の先頭がキャッシュライン(と型のアラインメント)に揃うように確保する
+		std::byte* pMemory = static_cast<std::byte*>(mpMemoryResource->allocate(memSize, mArchetype.getMemoryAlignment()));
+		std::memset(pMemory, 0, memSize);
+
+		return pMemory;
+	}
+
+	void IChunk::deallocateMemory(std::byte* pMemory, const std::size_t maxEntityNum) const
+	{
+		mpMemoryResource->deallocate(pMemory, getLayoutMemorySize(maxEntityNum), mArchetype.getMemoryAlignment());
+	}
+
+	std::byte* IChunk::resizeMemory(std::byte* pMemory, const std::size_t oldMaxEntityNum, const std::size_t newMaxEntityNum) const
+	{
+		assert(mpResizableMemoryResource);
+		return static_cast<std::byte*>(mpResizableMemoryResource->resize(pMemory, getLayoutMemorySize(oldMaxEntityNum), getLayoutMemorySize(newMaxEntityNum), mArchetype.getMemoryAlignment()));
+	}
+
 	void IChunk::dumpMemory() const
 	{
 		const std::byte* const p = mpMemory;
 		for (std::size_t typeIdx = 0; typeIdx < mArchetype.getTypeCount(); ++typeIdx)
 		{
 			std::cerr << "type begin----------\n";
-			const std::size_t offset = mArchetype.getTypeOffset(typeIdx, mMaxEntityNum);
-			const std::size_t all = offset + mArchetype.getTypeSize(typeIdx) * mMaxEntityNum;
-			for (std::size_t i = offset; i < all; ++i)
+			for (std::size_t row = 0; row < mMaxEntityNum; ++row)
 			{
-				if (i % 4 == 0)
+				// AoSoAの場合は列が連続していないので要素毎にオフセットを求める
+				const std::size_t offset = getAddress(typeIdx, row) - p;
+				const std::size_t all = offset + mArchetype.getTypeSize(typeIdx);
+				for (std::size_t i = offset; i < all; ++i)
 				{
-					std::cerr << std::dec << i << " ~ " << i + 3 << " : ";
-				}
+					if (i % 4 == 0)
+					{
+						std::cerr << std::dec << i << " ~ " << i + 3 << " : ";
+					}
 
-				std::cerr << std::hex << static_cast<int>(p[i]) << " ";
+					std::cerr << std::hex << static_cast<int>(p[i]) << " ";
 
-				if (i % 4 == 3)
-				{
-					std::cerr << "\n";
+					if (i % 4 == 3)
+					{
+						std::cerr << "\n";
+					}
 				}
 			}
 			std::cerr << "type end----------\n";
@@ -292,9 +588,9 @@ namespace mvecs
 
 	void IChunk::dumpIndexMemory() const
 	{
-		for (std::size_t i = 0; i < mpEntityIDs.size(); ++i)
+		for (std::size_t i = 0; i < mEntities.size(); ++i)
 		{
-			std::cerr << "[" << i << "] : " << *mpEntityIDs[i] << "\n";
+			std::cerr << "[" << i << "] : " << mEntities[i].getIndex() << " (gen " << mEntities[i].getGeneration() << ")\n";
 		}
 	}
 
@@ -0,0 +1,297 @@
+#include "../include/MVECS/MemoryResource.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define MVECS_HAS_MMAP 1
+#else
+#define MVECS_HAS_MMAP 0
+#endif
+
+namespace mvecs
+{
+    PoolMemoryResource::PoolMemoryResource(std::size_t maxBlockSize, std::pmr::memory_resource* pUpstream)
+        : mpUpstream(pUpstream)
+        , mMaxBlockSize(getClassSize(getSizeClass(maxBlockSize)))
+        , mCachedBytes(0)
+    {
+        assert(mpUpstream);
+        mFreeLists.resize(getSizeClass(mMaxBlockSize) + 1, nullptr);
+    }
+
+    PoolMemoryResource::~PoolMemoryResource()
+    {
+        release();
+    }
+
+    void PoolMemoryResource::release()
+    {
+        for (std::size_t sizeClass = 0; sizeClass < mFreeLists.size(); ++sizeClass)
+        {
+            const std::size_t blockSize = getClassSize(sizeClass);
+            while (mFreeLists[sizeClass])
+            {
+                FreeBlock* pBlock     = mFreeLists[sizeClass];
+                mFreeLists[sizeClass] = pBlock->pNext;
+                mpUpstream->deallocate(pBlock, blockSize, PoolAlignment);
+            }
+        }
+
+        mCachedBytes = 0;
+    }
+
+    std::size_t PoolMemoryResource::getCachedBytes() const
+    {
+        return mCachedBytes;
+    }
+
+    std::pmr::memory_resource* PoolMemoryResource::getUpstream() const
+    {
+        return mpUpstream;
+    }
+
+    void* PoolMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!isPooled(bytes, alignment))
+        {
+            return mpUpstream->allocate(bytes, alignment);
+        }
+
+        const std::size_t sizeClass = getSizeClass(bytes);
+        if (FreeBlock* pBlock = mFreeLists[sizeClass])
+        {
+            // 解放済みブロックを再利用する
+            mFreeLists[sizeClass] = pBlock->pNext;
+            mCachedBytes -= getClassSize(sizeClass);
+            return pBlock;
+        }
+
+        return mpUpstream->allocate(getClassSize(sizeClass), PoolAlignment);
+    }
+
+    void PoolMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+    {
+        if (!isPooled(bytes, alignment))
+        {
+            mpUpstream->deallocate(p, bytes, alignment);
+            return;
+        }
+
+        const std::size_t sizeClass = getSizeClass(bytes);
+        FreeBlock* pBlock           = static_cast<FreeBlock*>(p);
+        pBlock->pNext               = mFreeLists[sizeClass];
+        mFreeLists[sizeClass]       = pBlock;
+        mCachedBytes += getClassSize(sizeClass);
+    }
+
+    bool PoolMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    std::size_t PoolMemoryResource::getSizeClass(std::size_t bytes)
+    {
+        if (bytes <= MinBlockSize)
+        {
+            return 0;
+        }
+
+        // bytesは(2^exp, 2^(exp+1)]の範囲にある
+        std::size_t exp = 0;
+        for (std::size_t v = bytes - 1; v > 1; v >>= 1)
+        {
+            ++exp;
+        }
+
+        // 2^expから2^(exp-2)刻みで4分割したうちの何番目か
+        const std::size_t base = std::size_t(1) << exp;
+        const std::size_t step = base >> 2;
+        const std::size_t sub  = (bytes - base + step - 1) / step;
+
+        // MinBlockSize = 2^6
+        return (exp - 6) * 4 + sub;
+    }
+
+    std::size_t PoolMemoryResource::getClassSize(std::size_t sizeClass)
+    {
+        if (sizeClass == 0)
+        {
+            return MinBlockSize;
+        }
+
+        const std::size_t exp  = 6 + (sizeClass - 1) / 4;
+        const std::size_t base = std::size_t(1) << exp;
+
+        return base + ((sizeClass - 1) % 4 + 1) * (base >> 2);
+    }
+
+    bool PoolMemoryResource::isPooled(std::size_t bytes, std::size_t alignment) const
+    {
+        return bytes <= mMaxBlockSize && alignment <= PoolAlignment;
+    }
+
+    HugePageMemoryResource::HugePageMemoryResource(std::size_t minMappedSize, bool useHugeTLB, std::pmr::memory_resource* pUpstream)
+        : mpUpstream(pUpstream)
+        , mMinMappedSize(minMappedSize)
+        , mUseHugeTLB(useHugeTLB)
+        , mMappedBytes(0)
+    {
+        assert(mpUpstream);
+    }
+
+    HugePageMemoryResource::~HugePageMemoryResource()
+    {
+#if MVECS_HAS_MMAP
+        for (const auto& [p, mapping] : mMappings)
+        {
+            ::munmap(p, mapping.mappedBytes);
+        }
+#endif
+    }
+
+    bool HugePageMemoryResource::isSupported()
+    {
+        return MVECS_HAS_MMAP != 0;
+    }
+
+    std::size_t HugePageMemoryResource::getMappedBytes() const
+    {
+        return mMappedBytes;
+    }
+
+    std::pmr::memory_resource* HugePageMemoryResource::getUpstream() const
+    {
+        return mpUpstream;
+    }
+
+    void* HugePageMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (isMapped(bytes, alignment))
+        {
+            if (void* p = map(bytes))
+            {
+                return p;
+            }
+        }
+
+        // 小さい確保とmmapに失敗した場合
+        return mpUpstream->allocate(bytes, alignment);
+    }
+
+    void HugePageMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+    {
+#if MVECS_HAS_MMAP
+        if (auto itr = mMappings.find(p); itr != mMappings.end())
+        {
+            ::munmap(p, itr->second.mappedBytes);
+            mMappedBytes -= itr->second.mappedBytes;
+            mMappings.erase(itr);
+            return;
+        }
+#endif
+
+        mpUpstream->deallocate(p, bytes, alignment);
+    }
+
+    bool HugePageMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    void* HugePageMemoryResource::do_resize(void* p, std::size_t oldBytes, std::size_t newBytes, std::size_t alignment)
+    {
+#if MVECS_HAS_MMAP
+        auto itr = mMappings.find(p);
+        if (itr != mMappings.end() && isMapped(newBytes, alignment))
+        {
+            Mapping& mapping                 = itr->second;
+            const std::size_t newMappedBytes = (newBytes + HugePageSize - 1) / HugePageSize * HugePageSize;
+            if (newMappedBytes == mapping.mappedBytes)
+            {
+                return p;
+            }
+
+            // ページをコピーせずに付け替える(必要なら移動する)
+            void* pNew = ::mremap(p, mapping.mappedBytes, newMappedBytes, MREMAP_MAYMOVE);
+            if (pNew != MAP_FAILED)
+            {
+                if (!mapping.hugeTLB)
+                {
+                    ::madvise(pNew, newMappedBytes, MADV_HUGEPAGE);
+                }
+
+                const Mapping newMapping{newMappedBytes, mapping.hugeTLB};
+                mMappedBytes = mMappedBytes - mapping.mappedBytes + newMappedBytes;
+                mMappings.erase(itr);
+                mMappings.emplace(pNew, newMapping);
+
+                return pNew;
+            }
+        }
+#endif
+
+        // 付け替えられない場合は確保し直してコピーする
+        void* pNew = allocate(newBytes, alignment);
+        std::memcpy(pNew, p, std::min(oldBytes, newBytes));
+        deallocate(p, oldBytes, alignment);
+
+        return pNew;
+    }
+
+    void* HugePageMemoryResource::map(std::size_t bytes)
+    {
+#if MVECS_HAS_MMAP
+        const std::size_t mappedBytes = (bytes + HugePageSize - 1) / HugePageSize * HugePageSize;
+
+        if (mUseHugeTLB)
+        {
+            void* p = ::mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+            {
+                mMappings.emplace(p, Mapping{mappedBytes, true});
+                mMappedBytes += mappedBytes;
+                return p;
+            }
+        }
+
+        // Transparent Huge Pageが使われるように、Huge Pageの境界に揃えた領域を切り出す
+        void* pRaw = ::mmap(nullptr, mappedBytes + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pRaw == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        const std::uintptr_t raw     = reinterpret_cast<std::uintptr_t>(pRaw);
+        const std::uintptr_t aligned = (raw + HugePageSize - 1) & ~(std::uintptr_t(HugePageSize) - 1);
+        if (aligned != raw)
+        {
+            ::munmap(pRaw, aligned - raw);
+        }
+        if (const std::size_t tail = raw + mappedBytes + HugePageSize - (aligned + mappedBytes))
+        {
+            ::munmap(reinterpret_cast<void*>(aligned + mappedBytes), tail);
+        }
+
+        void* p = reinterpret_cast<void*>(aligned);
+        ::madvise(p, mappedBytes, MADV_HUGEPAGE);
+
+        mMappings.emplace(p, Mapping{mappedBytes, false});
+        mMappedBytes += mappedBytes;
+
+        return p;
+#else
+        (void)bytes;
+        return nullptr;
+#endif
+    }
+
+    bool HugePageMemoryResource::isMapped(std::size_t bytes, std::size_t alignment) const
+    {
+        // mmapした領域はHuge Pageの境界(MAP_HUGETLB以外で移動した後はページの境界)に揃う
+        return MVECS_HAS_MMAP && bytes >= mMinMappedSize && alignment <= 4096;
+    }
+}  // namespace mvecs
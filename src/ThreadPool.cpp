@@ -0,0 +1,228 @@
+#include "../include/MVECS/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace mvecs
+{
+    ThreadPool::ThreadPool(std::size_t threadNum)
+        : mpJob(nullptr)
+        , mGeneration(0)
+        , mPendingNum(0)
+        , mpException(nullptr)
+        , mCancelled(false)
+        , mStopped(false)
+    {
+        if (threadNum == 0)
+        {
+            threadNum = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        mpTaskQueues = std::make_unique<TaskQueue[]>(threadNum);
+
+        // 呼び出し元も仕事をするので、ワーカーは1つ少なくてよい
+        mWorkers.reserve(threadNum - 1);
+        for (std::size_t i = 1; i < threadNum; ++i)
+        {
+            mWorkers.emplace_back(&ThreadPool::work, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopped = true;
+        }
+        mWakeCondition.notify_all();
+
+        for (auto& worker : mWorkers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::run(const std::function<void(std::size_t)>& job)
+    {
+        std::lock_guard<std::mutex> runLock(mRunMutex);
+        dispatch(job);
+    }
+
+    void ThreadPool::runTasks(const std::size_t taskNum, const std::function<void(std::size_t)>& task, const std::size_t threadNum)
+    {
+        if (taskNum == 0)
+        {
+            return;
+        }
+
+        // タスクより多いスレッドは使わない
+        const std::size_t usedNum = std::min(threadNum == 0 ? getThreadNum() : std::min(threadNum, getThreadNum()), taskNum);
+
+        std::lock_guard<std::mutex> runLock(mRunMutex);
+
+        // 隣り合うタスク(同じChunkの隣り合う行など)が同じスレッドに行くように連続した範囲で配る
+        for (std::size_t i = 0; i < usedNum; ++i)
+        {
+            std::lock_guard<std::mutex> lock(mpTaskQueues[i].mutex);
+            mpTaskQueues[i].begin = i * taskNum / usedNum;
+            mpTaskQueues[i].end   = (i + 1) * taskNum / usedNum;
+        }
+
+        dispatch(
+            [this, usedNum, &task](const std::size_t threadIndex)
+            {
+                if (threadIndex >= usedNum)
+                {
+                    return;
+                }
+
+                // 自分のキューが空になったら盗み、どこからも盗めなくなったら終わる(実行中のタスクはdispatchが待つ)
+                // 他のスレッドのタスクが例外を投げたら、残りは実行せずに終わる
+                std::size_t taskIndex = 0;
+                do
+                {
+                    while (!mCancelled.load(std::memory_order_relaxed) && pop(mpTaskQueues[threadIndex], taskIndex))
+                    {
+                        task(taskIndex);
+                    }
+                } while (!mCancelled.load(std::memory_order_relaxed) && steal(threadIndex, usedNum));
+            });
+    }
+
+    std::size_t ThreadPool::getThreadNum() const
+    {
+        return mWorkers.size() + 1;
+    }
+
+    void ThreadPool::dispatch(const std::function<void(std::size_t)>& job)
+    {
+        mpException = nullptr;
+        mCancelled.store(false, std::memory_order_relaxed);
+
+        if (!mWorkers.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mpJob       = &job;
+                mPendingNum = mWorkers.size();
+                ++mGeneration;
+            }
+            mWakeCondition.notify_all();
+        }
+
+        // 呼び出し元は0番目のスレッドとして仕事をする
+        execute(job, 0);
+
+        std::exception_ptr pException = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mDoneCondition.wait(lock, [this]() { return mPendingNum == 0; });
+            mpJob = nullptr;
+            std::swap(pException, mpException);
+        }
+
+        // 全てのワーカーが終わってから投げ直す(jobが参照するものはまだ生きている)
+        if (pException)
+        {
+            std::rethrow_exception(pException);
+        }
+    }
+
+    void ThreadPool::execute(const std::function<void(std::size_t)>& job, const std::size_t threadIndex)
+    {
+        try
+        {
+            job(threadIndex);
+        }
+        catch (...)
+        {
+            mCancelled.store(true, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mpException)
+            {
+                mpException = std::current_exception();
+            }
+        }
+    }
+
+    bool ThreadPool::pop(TaskQueue& queue, std::size_t& taskIndex)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.begin >= queue.end)
+        {
+            return false;
+        }
+
+        taskIndex = queue.begin++;
+        return true;
+    }
+
+    bool ThreadPool::steal(const std::size_t threadIndex, const std::size_t threadNum)
+    {
+        // 隣のスレッドから順に見ていく(全員が同じスレッドから盗もうとしないように)
+        for (std::size_t offset = 1; offset < threadNum; ++offset)
+        {
+            TaskQueue& victim = mpTaskQueues[(threadIndex + offset) % threadNum];
+
+            std::size_t begin = 0, end = 0;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                const std::size_t restNum = victim.end - std::min(victim.begin, victim.end);
+                if (restNum == 0)
+                {
+                    continue;
+                }
+
+                // 残りの半分(切り上げ)を末尾から取る
+                end        = victim.end;
+                begin      = end - (restNum + 1) / 2;
+                victim.end = begin;
+            }
+
+            // 自分のキューは空なので、盗んだ範囲で置き換える
+            TaskQueue& own = mpTaskQueues[threadIndex];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin;
+            own.end   = end;
+            return true;
+        }
+
+        return false;
+    }
+
+    void ThreadPool::work(const std::size_t threadIndex)
+    {
+        std::uint64_t lastGeneration = 0;
+
+        while (true)
+        {
+            const std::function<void(std::size_t)>* pJob = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWakeCondition.wait(lock, [&]() { return mStopped || mGeneration != lastGeneration; });
+                if (mStopped)
+                {
+                    return;
+                }
+
+                lastGeneration = mGeneration;
+                pJob           = mpJob;
+            }
+
+            assert(pJob);
+            execute(*pJob, threadIndex);
+
+            bool done = false;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                done = --mPendingNum == 0;
+            }
+
+            if (done)
+            {
+                mDoneCondition.notify_one();
+            }
+        }
+    }
+}  // namespace mvecs